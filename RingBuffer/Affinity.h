@@ -0,0 +1,220 @@
+#pragma once
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+// CPU topology and thread pinning for the two thread benchmarks.
+// Reads which core, shared last level cache and package each CPU belongs to from
+// /sys/devices/system/cpu, classifies CPU pairs by how far apart they are, and pins
+// threads with pthread_setaffinity_np, so results do not depend on where the OS
+// happens to schedule the producer and consumer.
+// Linux only, elsewhere the topology is empty and pinning fails.
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Lomont {
+
+// how close two CPUs are, nearest first
+enum class Placement
+{
+	Unpinned,    // wherever the OS puts the threads
+	SameCpu,     // one CPU, the threads take turns, only when asked for
+	SameCore,    // SMT siblings, share L1 and L2
+	SharedCache, // different cores sharing the last level cache
+	SameSocket,  // same package, different last level caches
+	CrossSocket  // different packages
+};
+
+inline const char * PlacementName(Placement placement)
+{
+	switch (placement)
+	{
+	case Placement::SameCpu:     return "SameCpu";
+	case Placement::SameCore:    return "SameCore";
+	case Placement::SharedCache: return "SharedCache";
+	case Placement::SameSocket:  return "SameSocket";
+	case Placement::CrossSocket: return "CrossSocket";
+	default:                     return "Unpinned";
+	}
+}
+
+// CPUs for the producer and consumer threads
+struct CpuPair
+{
+	int producer = -1;
+	int consumer = -1;
+	Placement placement = Placement::Unpinned;
+};
+
+// the CPUs this process may run on, and where each sits
+class CpuTopology
+{
+public:
+	CpuTopology()
+	{
+#ifdef __linux__
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+			return;
+		for (auto id = 0; id < CPU_SETSIZE; ++id)
+		{
+			if (!CPU_ISSET(id, &allowed))
+				continue;
+			Cpu cpu;
+			cpu.id = id;
+			cpu.core = ReadCpuValue(id, "topology/core_id");
+			cpu.package = ReadCpuValue(id, "topology/physical_package_id");
+			cpu.cache = LastLevelCache(id);
+			cpus_.push_back(cpu);
+		}
+#endif
+	}
+
+	// # CPUs this process may use
+	std::size_t Cpus() const { return cpus_.size(); }
+
+	// how close CPUs a and b are, by their index in [0,Cpus())
+	Placement Classify(std::size_t a, std::size_t b) const
+	{
+		const auto & x = cpus_[a];
+		const auto & y = cpus_[b];
+		if (x.id == y.id)
+			return Placement::SameCpu;
+		if (x.package != y.package)
+			return Placement::CrossSocket;
+		if (x.core == y.core)
+			return Placement::SameCore;
+		if (x.cache >= 0 && x.cache == y.cache)
+			return Placement::SharedCache;
+		return x.cache < 0 ? Placement::SharedCache : Placement::SameSocket; // unknown cache, assume shared
+	}
+
+	// pair of CPUs by id, classified, false if the process may not use either
+	bool MakePair(int producer, int consumer, CpuPair & pair) const
+	{
+		const auto a = Index(producer), b = Index(consumer);
+		if (a < 0 || b < 0)
+			return false;
+		pair = CpuPair{ producer, consumer, Classify(a, b) };
+		return true;
+	}
+
+	// one CPU pair for each placement present, nearest first
+	// two different CPUs each, no SameCpu: the spinning tests would measure the scheduler
+	// quantum, not the ring, so pass a SameCpu pair explicitly to run it
+	std::vector<CpuPair> PairsByPlacement() const
+	{
+		std::vector<CpuPair> pairs;
+		for (auto a = 0U; a < cpus_.size(); ++a)
+			for (auto b = a + 1; b < cpus_.size(); ++b)
+			{
+				CpuPair pair{ cpus_[a].id, cpus_[b].id, Classify(a, b) };
+				auto found = false;
+				for (auto & p : pairs)
+					found |= p.placement == pair.placement;
+				if (!found)
+					pairs.push_back(pair);
+			}
+		for (auto i = 1U; i < pairs.size(); ++i) // few items, insertion sort by placement
+			for (auto j = i; j > 0 && pairs[j].placement < pairs[j - 1].placement; --j)
+				std::swap(pairs[j], pairs[j - 1]);
+		return pairs;
+	}
+
+private:
+	struct Cpu
+	{
+		int id;
+		int core;
+		int package;
+		int cache; // id of the last level cache, -1 if unknown
+	};
+
+	// index in cpus_ of CPU id, -1 if not usable
+	int Index(int id) const
+	{
+		for (auto i = 0U; i < cpus_.size(); ++i)
+			if (cpus_[i].id == id)
+				return (int)i;
+		return -1;
+	}
+
+	// integer from /sys/devices/system/cpu/cpu<id>/<name>, -1 if missing
+	static int ReadCpuValue(int id, const char * name)
+	{
+		char path[200];
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s", id, name);
+		auto file = fopen(path, "r");
+		if (file == nullptr)
+			return -1;
+		int value = -1;
+		if (fscanf(file, "%d", &value) != 1)
+			value = -1;
+		fclose(file);
+		return value;
+	}
+
+	// id of the highest level cache listed for the CPU, -1 if unknown
+	static int LastLevelCache(int id)
+	{
+		int level = -1, cache = -1;
+		for (auto index = 0; index < 10; ++index)
+		{
+			char name[50];
+			snprintf(name, sizeof(name), "cache/index%d/level", index);
+			const auto l = ReadCpuValue(id, name);
+			if (l < 0)
+				break;
+			snprintf(name, sizeof(name), "cache/index%d/id", index);
+			if (l > level)
+			{
+				level = l;
+				cache = ReadCpuValue(id, name);
+			}
+		}
+		return cache;
+	}
+
+	std::vector<Cpu> cpus_;
+};
+
+// pin the calling thread to one CPU, false if not allowed or not supported
+inline bool PinThisThread(int cpu)
+{
+#ifdef __linux__
+	if (cpu < 0 || cpu >= CPU_SETSIZE)
+		return false;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+
+// let the calling thread run on any CPU again, false if not supported
+inline bool UnpinThisThread()
+{
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (auto cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+		CPU_SET(cpu, &set); // kernel drops CPUs the process may not use
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+} // namespace Lomont
+
+#endif // AFFINITY_H
@@ -0,0 +1,211 @@
+#pragma once
+#ifndef ASYNC_RING_BUFFER_H
+#define ASYNC_RING_BUFFER_H
+
+// C++20 coroutine adapters for RingBuffer: co_await ring.Put(x) and co_await ring.Get().
+// Each completes synchronously, without suspending, when there is space or data, so the
+// fast path is a plain RingBuffer call plus a check for a waiting coroutine.
+// When full or empty the coroutine suspends and registers itself, and the other side's
+// next successful call hands it to the executor to resume.
+// Producer and consumer coroutines run on one single threaded Executor, so the waiter
+// registration needs no atomics. ONE PRODUCER AND ONE CONSUMER COROUTINE PER RING!
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define RING_HAS_COROUTINES
+
+#include <cassert>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <utility>
+
+#include "RingBuffer.h"
+
+namespace Lomont {
+
+// runs ready coroutines one at a time on the calling thread, in the order scheduled
+class Executor
+{
+public:
+	// queue a coroutine to resume
+	void Schedule(std::coroutine_handle<> handle) { ready_.push_back(handle); }
+
+	// resume coroutines until none are ready, return # resumed
+	std::size_t Run()
+	{
+		std::size_t resumed = 0;
+		while (!ready_.empty())
+		{
+			auto handle = ready_.front();
+			ready_.pop_front();
+			handle.resume();
+			++resumed;
+		}
+		return resumed;
+	}
+
+private:
+	std::deque<std::coroutine_handle<>> ready_;
+};
+
+// coroutine started by an Executor, owns its frame
+// starts suspended, Start schedules it, Done once it has run to the end
+class Task
+{
+public:
+	struct promise_type
+	{
+		Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; } // keep frame so Done works
+		void return_void() { }
+		void unhandled_exception() { std::terminate(); }
+	};
+
+	Task(Task && other) noexcept : handle_(std::exchange(other.handle_, nullptr)) { }
+	Task & operator=(Task && other) noexcept
+	{
+		if (this != &other)
+		{
+			if (handle_)
+				handle_.destroy();
+			handle_ = std::exchange(other.handle_, nullptr);
+		}
+		return *this;
+	}
+	Task(const Task &) = delete;
+	Task & operator=(const Task &) = delete;
+
+	~Task()
+	{
+		if (handle_)
+			handle_.destroy();
+	}
+
+	// schedule the task to begin running on the executor
+	void Start(Executor & executor) { executor.Schedule(handle_); }
+
+	bool Done() const { return !handle_ || handle_.done(); }
+
+private:
+	explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) { }
+	std::coroutine_handle<promise_type> handle_;
+};
+
+template<std::size_t N, typename DataType = char, typename IndexType = int32_t, typename RingMod = FastRingMod<N, IndexType>, typename Layout = PackedLayout>
+class AsyncRingBuffer
+{
+public:
+	explicit AsyncRingBuffer(Executor & executor) : executor_(executor) { }
+
+	AsyncRingBuffer(const AsyncRingBuffer &) = delete;
+	AsyncRingBuffer & operator=(const AsyncRingBuffer &) = delete;
+
+	// awaited by co_await Put, suspends while full
+	class PutAwaiter
+	{
+	public:
+		bool await_ready() { return ring_.TryPut(datum_); }
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			assert(!ring_.putWaiter_); // one producer
+			ring_.putWaiter_ = handle;
+			suspended_ = true;
+		}
+		void await_resume()
+		{
+			if (!suspended_)
+				return; // done in await_ready
+			const auto put = ring_.TryPut(datum_); // resumed by a Get, so there is room
+			assert(put);
+			(void)put;
+		}
+	private:
+		friend class AsyncRingBuffer;
+		PutAwaiter(AsyncRingBuffer & ring, DataType && datum) : ring_(ring), datum_(std::move(datum)) { }
+		AsyncRingBuffer & ring_;
+		DataType datum_;
+		bool suspended_ = false;
+	};
+
+	// awaited by co_await Get, suspends while empty, then gives the item
+	class GetAwaiter
+	{
+	public:
+		bool await_ready() { return ring_.TryGet(datum_); }
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			assert(!ring_.getWaiter_); // one consumer
+			ring_.getWaiter_ = handle;
+			suspended_ = true;
+		}
+		DataType await_resume()
+		{
+			if (suspended_)
+			{ // resumed by a Put, so there is an item
+				const auto got = ring_.TryGet(datum_);
+				assert(got);
+				(void)got;
+			}
+			return std::move(datum_);
+		}
+	private:
+		friend class AsyncRingBuffer;
+		explicit GetAwaiter(AsyncRingBuffer & ring) : ring_(ring) { }
+		AsyncRingBuffer & ring_;
+		DataType datum_{};
+		bool suspended_ = false;
+	};
+
+	// co_await to write an element, suspends while full
+	PutAwaiter Put(DataType datum) { return PutAwaiter(*this, std::move(datum)); }
+
+	// co_await to get an element, suspends while empty
+	GetAwaiter Get() { return GetAwaiter(*this); }
+
+	// try to write an element without suspending, fails if no space available
+	// wakes a consumer waiting for data
+	bool TryPut(const DataType & datum)
+	{
+		if (!ring_.Put(datum))
+			return false;
+		Wake(getWaiter_);
+		return true;
+	}
+
+	// try to get an element without suspending, fails if none available
+	// wakes a producer waiting for space
+	bool TryGet(DataType & data)
+	{
+		if (!ring_.Get(data))
+			return false;
+		Wake(putWaiter_);
+		return true;
+	}
+
+	std::size_t AvailableToRead() { return ring_.AvailableToRead(); }
+
+	std::size_t AvailableToWrite() { return ring_.AvailableToWrite(); }
+
+	// size of buffer, can hold exactly this many
+	std::size_t Size() const { return N; }
+
+private:
+	// hand a suspended waiter to the executor, once
+	void Wake(std::coroutine_handle<> & waiter)
+	{
+		if (waiter)
+			executor_.Schedule(std::exchange(waiter, nullptr));
+	}
+
+	Executor & executor_;
+	RingBuffer<N, DataType, IndexType, RingMod, Layout> ring_;
+	std::coroutine_handle<> putWaiter_; // producer suspended while full
+	std::coroutine_handle<> getWaiter_; // consumer suspended while empty
+};
+
+} // namespace Lomont
+
+#endif // coroutines
+
+#endif // ASYNC_RING_BUFFER_H
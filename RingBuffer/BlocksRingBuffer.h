@@ -73,8 +73,9 @@ public:
 		if (Size() - RingMod::Mod2N(2 * N + w - r) < n)
 			return false; // does not fit
 		auto t = RingMod::Mod1N(w);
-		for (auto i = 0; i < n; ++i)
-			buffer_[RingMod::Mod1N(t+i)] = data[i];
+		auto first = n < N - t ? n : N - t; // items before the wrap
+		Lomont::CopyItems(buffer_ + t, data, first);
+		Lomont::CopyItems(buffer_, data + first, n - first);
 		w = RingMod::Mod2N(w + n);
 		writeIndex_.store(w, std::memory_order_release);
 		return true;
@@ -88,8 +89,9 @@ public:
 		if (RingMod::Mod2N(2 * N + w - r) < n) // predicted available to read
 			return false; // not available
 		auto t = RingMod::Mod1N(r);
-		for (auto i = 0; i < n; ++i)
-			data[i] = buffer_[RingMod::Mod1N(t+i)];
+		auto first = n < N - t ? n : N - t; // items before the wrap
+		Lomont::CopyItems(data, buffer_ + t, first);
+		Lomont::CopyItems(data + first, buffer_, n - first);
 		r = RingMod::Mod2N(r + n);
 		readIndex_.store(r, std::memory_order_release);
 		return true;
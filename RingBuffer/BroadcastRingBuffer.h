@@ -0,0 +1,167 @@
+#pragma once
+#ifndef BROADCAST_RING_BUFFER_H
+#define BROADCAST_RING_BUFFER_H
+
+// Single producer, multiple consumer broadcast ring buffer, disruptor style.
+// Every consumer sees every item. Each consumer owns a read cursor, and the producer
+// only overwrites a slot once the slowest cursor has passed it, so one buffer serves
+// all consumers instead of a copy per consumer.
+// Producer keeps a cached slowest cursor, like pReadIndex_ in RingBuffer, and only
+// scans the cursors when that predicts full.
+// ONE PRODUCER, AND EACH CONSUMER MUST USE ITS OWN CURSOR!
+
+#include <cstdint>
+#include <cassert>
+#include <atomic>
+
+#include "RingBuffer.h" // for RingMod, CopyItems, RingSpans, CacheLineSize
+
+namespace Lomont {
+
+// Consumers cursors over one buffer of N items
+template<std::size_t Consumers, std::size_t N, typename DataType = char, typename IndexType = int32_t, typename RingMod = FastRingMod<N, IndexType>>
+class BroadcastRingBuffer
+{
+	static_assert(Consumers > 0, "BroadcastRingBuffer needs at least one consumer");
+public:
+	// number of consumer cursors
+	std::size_t Readers() const { return Consumers; }
+
+	// size of buffer, can hold exactly this many
+	std::size_t Size() const { return N; }
+
+	/************************** producer side ******************************/
+
+	// how many items can be written in [0,N], limited by the slowest consumer
+	// true size may be more since consumers may be removing
+	std::size_t AvailableToWrite()
+	{
+		const auto w = writeIndex_.load(std::memory_order_relaxed);
+		pMinRead_ = SlowestCursor(w);
+		return N - RingMod::Distance(w, pMinRead_);
+	}
+
+	bool IsFull() { return AvailableToWrite() == 0; }
+
+	// try to write an element, fails if the slowest consumer has not made room
+	bool Put(const DataType & datum)
+	{
+		const auto w = writeIndex_.load(std::memory_order_relaxed);
+		if (RingMod::Distance(w, pMinRead_) == N) // predicted full
+		{ // may be full, scan cursors, costing an atomic read per consumer
+			pMinRead_ = SlowestCursor(w);
+			if (RingMod::Distance(w, pMinRead_) == N)
+				return false;
+		}
+		buffer_[RingMod::Mod1N(w)] = datum;
+		writeIndex_.store(RingMod::Mod2N(w + 1), std::memory_order_release);
+		return true;
+	}
+
+	// try to write n elements, fails if no space available
+	bool Put(const DataType * data, std::size_t n)
+	{
+		const auto w = writeIndex_.load(std::memory_order_relaxed);
+		if (N - RingMod::Distance(w, pMinRead_) < n) // predicted available to write
+		{ // may not fit, scan cursors, costing an atomic read per consumer
+			pMinRead_ = SlowestCursor(w);
+			if (N - RingMod::Distance(w, pMinRead_) < n)
+				return false; // does not fit
+		}
+		auto spans = MakeSpans(RingMod::Mod1N(w), n); // at most two pieces, split at wrap
+		CopyItems(spans.first, data, spans.firstSize);
+		CopyItems(spans.second, data + spans.firstSize, spans.secondSize);
+		writeIndex_.store(RingMod::Mod2N(w + n), std::memory_order_release);
+		return true;
+	}
+
+	/************************** consumer side, each on its own cursor ******************************/
+
+	// how many items consumer can read in [0,N], true size may be more since producer may be adding
+	std::size_t AvailableToRead(std::size_t consumer)
+	{
+		auto & cursor = Cursor(consumer);
+		cursor.pWriteIndex_ = writeIndex_.load(std::memory_order_acquire);
+		return RingMod::Distance(cursor.pWriteIndex_, cursor.readIndex_.load(std::memory_order_relaxed));
+	}
+
+	bool IsEmpty(std::size_t consumer) { return AvailableToRead(consumer) == 0; }
+
+	// try to get the consumer's next element, fails if none available
+	bool Get(std::size_t consumer, DataType & data)
+	{
+		auto & cursor = Cursor(consumer);
+		const auto r = cursor.readIndex_.load(std::memory_order_relaxed);
+		if (r == cursor.pWriteIndex_) // predicted empty
+		{ // may be empty, check more exactly, costing an atomic read
+			cursor.pWriteIndex_ = writeIndex_.load(std::memory_order_acquire);
+			if (r == cursor.pWriteIndex_)
+				return false;
+		}
+		data = buffer_[RingMod::Mod1N(r)];
+		cursor.readIndex_.store(RingMod::Mod2N(r + 1), std::memory_order_release);
+		return true;
+	}
+
+	// try to get the consumer's next n elements, fails if not available
+	bool Get(std::size_t consumer, DataType * data, std::size_t n)
+	{
+		auto & cursor = Cursor(consumer);
+		const auto r = cursor.readIndex_.load(std::memory_order_relaxed);
+		if ((std::size_t)RingMod::Distance(cursor.pWriteIndex_, r) < n) // predicted available to read
+		{ // may not be available, check more exactly, costing an atomic read
+			cursor.pWriteIndex_ = writeIndex_.load(std::memory_order_acquire);
+			if ((std::size_t)RingMod::Distance(cursor.pWriteIndex_, r) < n)
+				return false; // not available
+		}
+		auto spans = MakeSpans(RingMod::Mod1N(r), n); // at most two pieces, split at wrap
+		CopyItems(data, spans.first, spans.firstSize);
+		CopyItems(data + spans.firstSize, spans.second, spans.secondSize);
+		cursor.readIndex_.store(RingMod::Mod2N(r + n), std::memory_order_release);
+		return true;
+	}
+
+private:
+	// each consumer's fields on their own cache line, so consumers do not slow each other
+	struct alignas(CacheLineSize) ReadCursor
+	{
+		std::atomic<IndexType> readIndex_{ 0 };
+		IndexType pWriteIndex_{ 0 }; // predictive write index, cache neighbors
+	};
+
+	ReadCursor & Cursor(std::size_t consumer)
+	{
+		assert(consumer < Consumers);
+		return cursors_[consumer];
+	}
+
+	// read index of the consumer furthest behind write index w
+	IndexType SlowestCursor(IndexType w) const
+	{
+		auto slowest = cursors_[0].readIndex_.load(std::memory_order_acquire);
+		for (auto i = 1U; i < Consumers; ++i)
+		{
+			const auto r = cursors_[i].readIndex_.load(std::memory_order_acquire);
+			if (RingMod::Distance(w, r) > RingMod::Distance(w, slowest))
+				slowest = r;
+		}
+		return slowest;
+	}
+
+	// spans covering n items starting at buffer position t in [0,N-1], split at the end of the buffer
+	RingSpans<DataType> MakeSpans(std::size_t t, std::size_t n)
+	{
+		const auto firstSize = n < N - t ? n : N - t;
+		return { buffer_ + t, firstSize, buffer_, n - firstSize };
+	}
+
+	// producer fields, then shared read only buffer, then consumer cursors
+	alignas(CacheLineSize) std::atomic<IndexType> writeIndex_{ 0 };
+	IndexType pMinRead_{ 0 }; // predictive slowest read index, cache neighbors
+	alignas(CacheLineSize) DataType buffer_[N];
+	ReadCursor cursors_[Consumers];
+};
+
+} // namespace Lomont
+
+#endif // BROADCAST_RING_BUFFER_H
@@ -0,0 +1,225 @@
+#pragma once
+#ifndef DYNAMIC_RING_BUFFER_H
+#define DYNAMIC_RING_BUFFER_H
+
+// Single producer, single consumer ring buffer with capacity set at runtime.
+// Same design and API as RingBuffer, but storage is allocated once, cache line
+// aligned, on the heap (optionally on huge pages), so size can come from config
+// and large buffers do not live on the stack.
+// MORE THREADS THAN THAT WILL NOT WORK!
+
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "RingBuffer.h" // for CopyItems, RingSpans
+
+namespace Lomont {
+
+template<typename DataType = char, typename IndexType = uint32_t>
+class DynamicRingBuffer
+{
+public:
+	// capacity in items, any size, powers of two use masks instead of compares
+	// hugePages requests transparent huge pages for the storage where supported (Linux)
+	explicit DynamicRingBuffer(std::size_t capacity, bool hugePages = false) : size_(capacity)
+	{
+		if (capacity == 0 || 2 * capacity - 1 > static_cast<std::size_t>(std::numeric_limits<IndexType>::max()))
+			throw std::invalid_argument("DynamicRingBuffer size must be in [1, max IndexType/2]");
+		isPowerOfTwo_ = (capacity & (capacity - 1)) == 0;
+		buffer_ = Allocate(capacity * sizeof(DataType), hugePages);
+		std::uninitialized_default_construct_n(buffer_, size_);
+	}
+
+	~DynamicRingBuffer()
+	{
+		std::destroy_n(buffer_, size_);
+		Free();
+	}
+
+	DynamicRingBuffer(const DynamicRingBuffer &) = delete;
+	DynamicRingBuffer & operator=(const DynamicRingBuffer &) = delete;
+
+	// how many items available to read in [0,Size]
+	// if called from consumer, true size may be more since producer can be adding
+	// if called from producer, true size may be less since consumer may be removing
+	// undefined to call from any other thread
+	std::size_t AvailableToRead() const
+	{
+		return Mod2N(2 * size_ + writeIndex_.load(std::memory_order_acquire) - readIndex_.load(std::memory_order_acquire));
+	}
+
+	// how many items available to write in [0,Size]
+	// if called from consumer, true size may be less since producer can be adding
+	// if called from producer, true size may be more since consumer may be removing
+	// undefined to call from any other thread
+	std::size_t AvailableToWrite() const
+	{
+		return Size() - AvailableToRead();
+	}
+
+	bool IsEmpty() const { return AvailableToRead() == 0; }
+
+	bool IsFull()  const { return AvailableToRead() == Size(); }
+
+	// size of buffer, can hold exactly this many
+	std::size_t Size() const { return size_; }
+
+	// try to write an element, fails if no space available
+	bool Put(const DataType & datum)
+	{
+		const auto w = writeIndex_.load(std::memory_order_relaxed);
+		if (Mod2N(w + size_) != readIndex_.load(std::memory_order_acquire)) // full when read index is N behind
+		{
+			buffer_[Mod1N(w)] = datum;
+			writeIndex_.store(Mod2N(w + 1), std::memory_order_release);
+			return true;
+		}
+		// buffer full
+		return false;
+	}
+
+	// try to get an element, fails if none available
+	bool Get(DataType & data)
+	{
+		const auto r = readIndex_.load(std::memory_order_relaxed);
+		if (r != writeIndex_.load(std::memory_order_acquire))
+		{
+			data = buffer_[Mod1N(r)];
+			readIndex_.store(Mod2N(r + 1), std::memory_order_release);
+			return true;
+		}
+		return false; // buffer empty
+	}
+
+	// try to write n elements, fails if no space available
+	bool Put(const DataType * data, std::size_t n)
+	{
+		auto w = writeIndex_.load(std::memory_order_relaxed);
+		if (Size() - Mod2N(2 * size_ + w - pReadIndex_) < n) // predicted available to write
+		{ // may not fit, check more exactly, costing an atomic read
+			pReadIndex_ = readIndex_.load(std::memory_order_acquire);
+			if (Size() - Mod2N(2 * size_ + w - pReadIndex_) < n) // current available to write
+				return false; // does not fit
+		}
+		auto spans = MakeSpans(Mod1N(w), n); // at most two pieces, split at wrap
+		CopyItems(spans.first, data, spans.firstSize);
+		CopyItems(spans.second, data + spans.firstSize, spans.secondSize);
+		writeIndex_.store(Mod2N(w + n), std::memory_order_release);
+		return true;
+	}
+
+	// try to get n elements, fails if not available
+	bool Get(DataType * data, std::size_t n)
+	{
+		auto r = readIndex_.load(std::memory_order_relaxed);
+		if (Mod2N(2 * size_ + pWriteIndex_ - r) < n) // predicted available to read
+		{ // may not be available, check more exactly, costing an atomic read
+			pWriteIndex_ = writeIndex_.load(std::memory_order_acquire);
+			if (Mod2N(2 * size_ + pWriteIndex_ - r) < n) // current available to read
+				return false; // not available
+		}
+		auto spans = MakeSpans(Mod1N(r), n); // at most two pieces, split at wrap
+		CopyItems(data, spans.first, spans.firstSize);
+		CopyItems(data + spans.firstSize, spans.second, spans.secondSize);
+		readIndex_.store(Mod2N(r + n), std::memory_order_release);
+		return true;
+	}
+
+private:
+	// power of two sizes take the mask, others the MidRingMod 'if'
+	// branch on isPowerOfTwo_ never changes, so predicts perfectly
+	// given integer in [0,2N-1], return mod N in [0,N-1]
+	IndexType Mod1N(std::size_t index) const
+	{
+		assert(index < 2 * size_);
+		if (isPowerOfTwo_)
+			return static_cast<IndexType>(index & (size_ - 1));
+		return static_cast<IndexType>(index < size_ ? index : index - size_);
+	}
+
+	// given integer in [0,4N-1], return mod M in [0,2N-1]
+	IndexType Mod2N(std::size_t index) const
+	{
+		assert(index < 4 * size_);
+		if (isPowerOfTwo_)
+			return static_cast<IndexType>(index & (2 * size_ - 1));
+		return static_cast<IndexType>(index < 2 * size_ ? index : index - 2 * size_);
+	}
+
+	// spans covering n items starting at buffer position t in [0,N-1], split at the end of the buffer
+	RingSpans<DataType> MakeSpans(std::size_t t, std::size_t n)
+	{
+		const auto firstSize = n < size_ - t ? n : size_ - t;
+		return { buffer_ + t, firstSize, buffer_, n - firstSize };
+	}
+
+	// cache line aligned storage, or huge page backed if requested and available
+	DataType * Allocate(std::size_t bytes, bool hugePages)
+	{
+		constexpr std::size_t lineSize = 64;
+		static_assert(alignof(DataType) <= lineSize, "DynamicRingBuffer DataType alignment too large");
+#ifdef __linux__
+		if (hugePages)
+		{
+			constexpr std::size_t hugePageSize = 2 << 20;
+			mappedBytes_ = (bytes + hugePageSize - 1) & ~(hugePageSize - 1);
+			auto p = mmap(nullptr, mappedBytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == MAP_FAILED)
+				throw std::bad_alloc();
+			madvise(p, mappedBytes_, MADV_HUGEPAGE); // best effort, falls back to normal pages
+			return static_cast<DataType*>(p);
+		}
+#else
+		(void)hugePages; // not supported, use normal pages
+#endif
+		bytes = (bytes + lineSize - 1) & ~(lineSize - 1); // aligned_alloc needs a multiple of alignment
+#ifdef _WIN32
+		auto p = _aligned_malloc(bytes, lineSize);
+#else
+		auto p = std::aligned_alloc(lineSize, bytes);
+#endif
+		if (p == nullptr)
+			throw std::bad_alloc();
+		return static_cast<DataType*>(p);
+	}
+
+	void Free()
+	{
+#ifdef __linux__
+		if (mappedBytes_ != 0)
+		{
+			munmap(buffer_, mappedBytes_);
+			return;
+		}
+#endif
+#ifdef _WIN32
+		_aligned_free(buffer_);
+#else
+		std::free(buffer_);
+#endif
+	}
+
+	// producer line, heap storage and size line, consumer line, as PaddedLayout
+	alignas(CacheLineSize) std::atomic<IndexType> writeIndex_{ 0 };
+	IndexType pReadIndex_{ 0 }; // predictive read index, cache neighbors
+	alignas(CacheLineSize) DataType * buffer_{ nullptr };
+	std::size_t size_;
+	bool isPowerOfTwo_;
+	std::size_t mappedBytes_{ 0 }; // nonzero when storage came from mmap
+	alignas(CacheLineSize) std::atomic<IndexType> readIndex_{ 0 };
+	IndexType pWriteIndex_{ 0 }; // predictive write index, cache neighbors
+};
+
+} // namespace Lomont
+
+#endif // DYNAMIC_RING_BUFFER_H
@@ -0,0 +1,146 @@
+#pragma once
+#ifndef EVENT_RING_BUFFER_H
+#define EVENT_RING_BUFFER_H
+
+// Single producer, single consumer ring buffer with an eventfd the consumer can put in an
+// epoll or poll loop next to sockets, instead of spinning on IsEmpty.
+// The fd is signalled only on the empty to non-empty transition: a consumer that finds the
+// ring empty sets an armed flag, and the producer writes the eventfd only when it sees the
+// flag, clearing it. While the consumer keeps up there are no syscalls on either side.
+// The producer pays a full fence per Put (per block for block Put) to pair with the arm.
+// Consumer loop: Get until it fails, which arms, then wait for the fd, Acknowledge, repeat.
+// Linux only, uses eventfd.
+// MORE THREADS THAN THAT WILL NOT WORK!
+
+#ifdef __linux__
+
+#include <cstdint>
+#include <cerrno>
+#include <atomic>
+#include <system_error>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "RingBuffer.h"
+
+namespace Lomont {
+
+template<std::size_t N, typename DataType = char, typename IndexType = int32_t, typename RingMod = FastRingMod<N, IndexType>, typename Layout = PackedLayout>
+class EventRingBuffer
+{
+public:
+	EventRingBuffer() : fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+	{
+		if (fd_ < 0)
+			throw std::system_error(errno, std::generic_category(), "eventfd");
+	}
+
+	~EventRingBuffer() { close(fd_); }
+
+	EventRingBuffer(const EventRingBuffer &) = delete;
+	EventRingBuffer & operator=(const EventRingBuffer &) = delete;
+
+	// readable when items arrived while the consumer was armed, add to epoll for EPOLLIN
+	int Fd() const { return fd_; }
+
+	// size of buffer, can hold exactly this many
+	std::size_t Size() const { return N; }
+
+	/************************** producer side ******************************/
+
+	// try to write an element, fails if no space available
+	// signals the fd if the consumer is waiting
+	bool Put(const DataType & datum)
+	{
+		if (!ring_.Put(datum))
+			return false;
+		Notify();
+		return true;
+	}
+
+	// try to write n elements, fails if no space available, one fence for the block
+	bool Put(const DataType * data, std::size_t n)
+	{
+		if (!ring_.Put(data, n))
+			return false;
+		Notify();
+		return true;
+	}
+
+	// eventfd writes made by the producer, each one syscall, producer only
+	uint64_t Signals() const { return signals_; }
+
+	/************************** consumer side ******************************/
+
+	// try to get an element, fails if none available
+	// failing arms the notifier, so the fd is signalled on the next Put
+	bool Get(DataType & data)
+	{
+		if (ring_.Get(data))
+			return true;
+		Arm();
+		if (!ring_.Get(data))
+			return false; // stays armed
+		armed_.store(false, std::memory_order_relaxed); // raced a Put, which may have signalled, giving one spurious wake
+		return true;
+	}
+
+	// try to get n elements, fails if not available, arms the notifier when it fails
+	bool Get(DataType * data, std::size_t n)
+	{
+		if (ring_.Get(data, n))
+			return true;
+		Arm();
+		if (!ring_.Get(data, n))
+			return false; // stays armed
+		armed_.store(false, std::memory_order_relaxed);
+		return true;
+	}
+
+	// clear the fd after a wakeup, before draining, one syscall
+	// returns false if it was not signalled
+	bool Acknowledge()
+	{
+		uint64_t count;
+		return read(fd_, &count, sizeof(count)) == sizeof(count);
+	}
+
+	bool IsEmpty() { return ring_.IsEmpty(); }
+
+	std::size_t AvailableToRead() { return ring_.AvailableToRead(); }
+
+private:
+	// consumer found the ring empty, ask the producer to signal
+	void Arm()
+	{
+		armed_.store(true, std::memory_order_relaxed);
+		// pairs with the fence in Notify: either the producer sees armed, or the recheck sees its item
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	// producer published items, signal if the consumer is armed
+	void Notify()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (armed_.load(std::memory_order_relaxed) && armed_.exchange(false, std::memory_order_relaxed))
+		{
+			const uint64_t one = 1;
+			while (write(fd_, &one, sizeof(one)) < 0 && errno == EINTR)
+			{ // retry
+			}
+			++signals_;
+		}
+	}
+
+	RingBuffer<N, DataType, IndexType, RingMod, Layout> ring_;
+	alignas(CacheLineSize) std::atomic<bool> armed_{ false }; // set by consumer when idle, read by producer each Put
+	uint64_t signals_ = 0;  // producer only
+	int fd_;
+};
+
+} // namespace Lomont
+
+#endif // __linux__
+
+#endif // EVENT_RING_BUFFER_H
@@ -0,0 +1,193 @@
+#pragma once
+#ifndef MAPPED_RING_BUFFER_H
+#define MAPPED_RING_BUFFER_H
+
+// Single producer, single consumer ring buffer with storage mapped twice, back to back,
+// in virtual memory. Slot i and slot i+Size() are the same memory, so any run of up to
+// Size() items starting anywhere in the buffer is contiguous and block copies never
+// split at the wrap. Capacity is set at runtime, in bytes must be a multiple of the page size.
+// Linux only, uses memfd_create and mmap.
+// MORE THREADS THAN THAT WILL NOT WORK!
+
+#ifdef __linux__
+
+#include <cstdint>
+#include <cassert>
+#include <cerrno>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "RingBuffer.h" // for CopyItems
+
+namespace Lomont {
+
+template<typename DataType = char, typename IndexType = uint32_t>
+class MappedRingBuffer
+{
+public:
+	static_assert(std::is_trivially_copyable<DataType>::value, "MappedRingBuffer DataType must be trivially copyable");
+
+	// capacity in items, capacity * sizeof(DataType) must be a multiple of the page size
+	explicit MappedRingBuffer(std::size_t capacity) : size_(capacity)
+	{
+		const auto bytes = capacity * sizeof(DataType);
+		const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+		if (capacity == 0 || bytes % page != 0)
+			throw std::invalid_argument("MappedRingBuffer size must be a multiple of the page size");
+		if (2 * capacity - 1 > static_cast<std::size_t>(std::numeric_limits<IndexType>::max()))
+			throw std::invalid_argument("MappedRingBuffer size too large for IndexType");
+
+		const auto fd = memfd_create("MappedRingBuffer", MFD_CLOEXEC);
+		if (fd < 0)
+			throw std::system_error(errno, std::generic_category(), "memfd_create");
+		if (ftruncate(fd, bytes) != 0)
+			Fail(fd, nullptr, "ftruncate");
+
+		// reserve 2x address space, then map the file into each half
+		auto base = static_cast<char*>(mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (base == MAP_FAILED)
+			Fail(fd, nullptr, "mmap");
+		for (auto half : { base, base + bytes })
+		{ // populate so page faults are not charged to the first pass through the buffer
+			if (mmap(half, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED | MAP_POPULATE, fd, 0) == MAP_FAILED)
+				Fail(fd, base, "mmap");
+		}
+		close(fd); // mappings keep the memory alive
+		buffer_ = reinterpret_cast<DataType*>(base);
+	}
+
+	~MappedRingBuffer()
+	{
+		munmap(buffer_, 2 * size_ * sizeof(DataType));
+	}
+
+	MappedRingBuffer(const MappedRingBuffer &) = delete;
+	MappedRingBuffer & operator=(const MappedRingBuffer &) = delete;
+
+	// how many items available to read in [0,Size]
+	// if called from consumer, true size may be more since producer can be adding
+	// if called from producer, true size may be less since consumer may be removing
+	// undefined to call from any other thread
+	std::size_t AvailableToRead() const
+	{
+		return Mod2N(2 * size_ + writeIndex_.load(std::memory_order_acquire) - readIndex_.load(std::memory_order_acquire));
+	}
+
+	// how many items available to write in [0,Size]
+	// if called from consumer, true size may be less since producer can be adding
+	// if called from producer, true size may be more since consumer may be removing
+	// undefined to call from any other thread
+	std::size_t AvailableToWrite() const
+	{
+		return Size() - AvailableToRead();
+	}
+
+	bool IsEmpty() const { return AvailableToRead() == 0; }
+
+	bool IsFull()  const { return AvailableToRead() == Size(); }
+
+	// size of buffer, can hold exactly this many
+	std::size_t Size() const { return size_; }
+
+	// try to write an element, fails if no space available
+	bool Put(const DataType & datum)
+	{
+		const auto w = writeIndex_.load(std::memory_order_relaxed);
+		if (Mod2N(w + size_) != readIndex_.load(std::memory_order_acquire)) // full when read index is N behind
+		{
+			buffer_[Mod1N(w)] = datum;
+			writeIndex_.store(Mod2N(w + 1), std::memory_order_release);
+			return true;
+		}
+		// buffer full
+		return false;
+	}
+
+	// try to get an element, fails if none available
+	bool Get(DataType & data)
+	{
+		const auto r = readIndex_.load(std::memory_order_relaxed);
+		if (r != writeIndex_.load(std::memory_order_acquire))
+		{
+			data = buffer_[Mod1N(r)];
+			readIndex_.store(Mod2N(r + 1), std::memory_order_release);
+			return true;
+		}
+		return false; // buffer empty
+	}
+
+	// try to write n elements, fails if no space available
+	bool Put(const DataType * data, std::size_t n)
+	{
+		auto w = writeIndex_.load(std::memory_order_relaxed);
+		if (Size() - Mod2N(2 * size_ + w - pReadIndex_) < n) // predicted available to write
+		{ // may not fit, check more exactly, costing an atomic read
+			pReadIndex_ = readIndex_.load(std::memory_order_acquire);
+			if (Size() - Mod2N(2 * size_ + w - pReadIndex_) < n) // current available to write
+				return false; // does not fit
+		}
+		CopyItems(buffer_ + Mod1N(w), data, n); // second mapping makes this contiguous
+		writeIndex_.store(Mod2N(w + n), std::memory_order_release);
+		return true;
+	}
+
+	// try to get n elements, fails if not available
+	bool Get(DataType * data, std::size_t n)
+	{
+		auto r = readIndex_.load(std::memory_order_relaxed);
+		if (Mod2N(2 * size_ + pWriteIndex_ - r) < n) // predicted available to read
+		{ // may not be available, check more exactly, costing an atomic read
+			pWriteIndex_ = writeIndex_.load(std::memory_order_acquire);
+			if (Mod2N(2 * size_ + pWriteIndex_ - r) < n) // current available to read
+				return false; // not available
+		}
+		CopyItems(data, buffer_ + Mod1N(r), n); // second mapping makes this contiguous
+		readIndex_.store(Mod2N(r + n), std::memory_order_release);
+		return true;
+	}
+
+private:
+	// same 'if' trick as MidRingMod, with runtime size
+	// given integer in [0,2N-1], return mod N in [0,N-1]
+	IndexType Mod1N(std::size_t index) const
+	{
+		assert(index < 2 * size_);
+		return static_cast<IndexType>(index < size_ ? index : index - size_);
+	}
+
+	// given integer in [0,4N-1], return mod M in [0,2N-1]
+	IndexType Mod2N(std::size_t index) const
+	{
+		assert(index < 4 * size_);
+		return static_cast<IndexType>(index < 2 * size_ ? index : index - 2 * size_);
+	}
+
+	// clean up partial construction and throw
+	[[noreturn]] void Fail(int fd, char * base, const char * what)
+	{
+		const auto error = errno;
+		if (base != nullptr)
+			munmap(base, 2 * size_ * sizeof(DataType));
+		close(fd);
+		throw std::system_error(error, std::generic_category(), what);
+	}
+
+	// producer line, mapping line, consumer line, as PaddedLayout
+	alignas(CacheLineSize) std::atomic<IndexType> writeIndex_{ 0 };
+	IndexType pReadIndex_{ 0 }; // predictive read index, cache neighbors
+	alignas(CacheLineSize) DataType * buffer_{ nullptr }; // 2 * size_ items, second half aliases first
+	std::size_t size_;
+	alignas(CacheLineSize) std::atomic<IndexType> readIndex_{ 0 };
+	IndexType pWriteIndex_{ 0 }; // predictive write index, cache neighbors
+};
+
+} // namespace Lomont
+
+#endif // __linux__
+
+#endif // MAPPED_RING_BUFFER_H
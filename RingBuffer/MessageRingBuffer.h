@@ -0,0 +1,125 @@
+#pragma once
+#ifndef MESSAGE_RING_BUFFER_H
+#define MESSAGE_RING_BUFFER_H
+
+// Variable length messages over a single producer, single consumer ring.
+// Each message is a header word holding its length followed by the payload, written and
+// read in place through the ring's zero copy calls, so one ring operation per message.
+// A message never straddles the wrap: when it does not fit before the end of the buffer,
+// the producer writes a skip marker covering the tail and places the message at the start.
+// Skipped tails cost space, so keep messages well under the buffer size.
+// Storage is 64 bit words, so every payload starts 8 byte aligned.
+// MORE THREADS THAN THAT WILL NOT WORK!
+
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+
+#include "RingBuffer.h"
+
+namespace Lomont {
+
+// payload of a message read in place, valid until the next ReadMessage or ReleaseMessage
+struct MessageView
+{
+	const char * data;
+	std::size_t size;
+	bool Empty() const { return data == nullptr; }
+};
+
+// Words 64 bit words of storage, a message takes 1 + ceil(length/8) of them
+template<std::size_t Words, typename Layout = PackedLayout>
+class MessageRingBuffer
+{
+	static_assert(Words >= 2, "MessageRingBuffer needs room for a header and payload");
+public:
+	// every payload starts on this alignment
+	static constexpr std::size_t Alignment = sizeof(uint64_t);
+
+	// largest message that can ever be written
+	static constexpr std::size_t MaxMessageSize() { return (Words - 1) * sizeof(uint64_t); }
+
+	// try to write a message of length bytes, fails if no space available
+	bool TryWriteMessage(const void * data, std::size_t length)
+	{
+		assert(length <= MaxMessageSize() && length <= LengthMask);
+		const auto words = 1 + (length + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+		const auto tail = Words - writePos_; // words before the wrap
+		if (tail < words)
+		{ // would straddle the wrap, pad over the tail, message goes at the start
+			auto spans = ring_.ReserveWrite(tail);
+			if (spans.Size() < tail)
+				return false; // tail not free yet
+			spans.first[0] = SkipMarker | tail;
+			ring_.CommitWrite(tail);
+			writePos_ = 0;
+		}
+		auto spans = ring_.ReserveWrite(words);
+		if (spans.Size() < words)
+			return false; // does not fit
+		assert(spans.firstSize == words); // never split, checked against the tail
+		Write(spans.first, data, length);
+		ring_.CommitWrite(words);
+		writePos_ = writePos_ + words == Words ? 0 : writePos_ + words;
+		return true;
+	}
+
+	// get the next message in place, empty view if none available
+	// releases the previously read message
+	MessageView ReadMessage()
+	{
+		ReleaseMessage();
+		for (;;)
+		{
+			auto spans = ring_.ReserveRead(1);
+			if (spans.firstSize == 0)
+				return { nullptr, 0 };
+			const auto header = spans.first[0];
+			if (header & SkipMarker)
+			{ // padding to the end of the buffer, message is at the start
+				ring_.ReleaseRead(static_cast<std::size_t>(header & LengthMask));
+				continue;
+			}
+			const auto length = static_cast<std::size_t>(header & LengthMask);
+			const auto words = 1 + (length + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+			spans = ring_.ReserveRead(words); // committed with the header, never split
+			assert(spans.firstSize == words);
+			held_ = words;
+			return { reinterpret_cast<const char*>(spans.first + 1), length };
+		}
+	}
+
+	// free the space of the message from the last ReadMessage, the view is then invalid
+	void ReleaseMessage()
+	{
+		if (held_ == 0)
+			return;
+		ring_.ReleaseRead(held_);
+		held_ = 0;
+	}
+
+	bool IsEmpty() const { return ring_.IsEmpty(); }
+
+	// size of storage in bytes, messages use a header word each
+	std::size_t Size() const { return Words * sizeof(uint64_t); }
+
+private:
+	static constexpr uint64_t SkipMarker = uint64_t(1) << 63;
+	static constexpr uint64_t LengthMask = 0xFFFFFFFF;
+
+	// header then payload into contiguous words
+	static void Write(uint64_t * words, const void * data, std::size_t length)
+	{
+		words[0] = length;
+		if (length != 0)
+			std::memcpy(words + 1, data, length);
+	}
+
+	std::size_t writePos_ = 0; // producer: buffer position of the next header
+	RingBuffer<Words, uint64_t, int32_t, FastRingMod<Words, int32_t>, Layout> ring_;
+	std::size_t held_ = 0; // consumer: words of the message being viewed
+};
+
+} // namespace Lomont
+
+#endif // MESSAGE_RING_BUFFER_H
@@ -0,0 +1,186 @@
+#pragma once
+#ifndef MPMC_RING_BUFFER_H
+#define MPMC_RING_BUFFER_H
+
+// Bounded multiple producer, multiple consumer queue, each item goes to exactly one consumer.
+// Vyukov style: each slot holds a sequence number saying whose turn it is, producers
+// and consumers claim positions with a CAS on a shared counter, then hand the slot over
+// by storing the next sequence number. Same Put/Get surface as RingBuffer.
+// Positions are free running 64 bit counters, so uses SequenceRingMod for the slot mask.
+
+#include <cstdint>
+#include <cassert>
+#include <atomic>
+
+#include "RingBuffer.h" // for SequenceRingMod, CacheLineSize
+
+namespace Lomont {
+
+template<std::size_t N, typename DataType = char, typename RingMod = SequenceRingMod<N, uint64_t>>
+class MpmcRingBuffer
+{
+public:
+	MpmcRingBuffer()
+	{
+		for (auto i = 0U; i < N; ++i)
+			slots_[i].sequence_.store(i, std::memory_order_relaxed);
+	}
+
+	MpmcRingBuffer(const MpmcRingBuffer &) = delete;
+	MpmcRingBuffer & operator=(const MpmcRingBuffer &) = delete;
+
+	// how many items available to read in [0,N], only a hint while other threads are active
+	std::size_t AvailableToRead() const
+	{
+		const auto r = dequeuePos_.load(std::memory_order_acquire);
+		const auto w = enqueuePos_.load(std::memory_order_acquire);
+		const auto count = static_cast<int64_t>(w - r);
+		return count < 0 ? 0 : count > static_cast<int64_t>(N) ? N : static_cast<std::size_t>(count);
+	}
+
+	// how many items available to write in [0,N], only a hint while other threads are active
+	std::size_t AvailableToWrite() const
+	{
+		return Size() - AvailableToRead();
+	}
+
+	bool IsEmpty() const { return AvailableToRead() == 0; }
+
+	bool IsFull()  const { return AvailableToRead() == Size(); }
+
+	// size of buffer, can hold exactly this many
+	std::size_t Size() const { return N; }
+
+	// try to write an element, fails if no space available
+	bool Put(const DataType & datum)
+	{
+		auto pos = enqueuePos_.load(std::memory_order_relaxed);
+		Slot * slot;
+		for (;;)
+		{
+			slot = &slots_[RingMod::Mod1N(pos)];
+			const auto diff = static_cast<int64_t>(slot->sequence_.load(std::memory_order_acquire) - pos);
+			if (diff == 0)
+			{ // slot free this lap, claim it
+				if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false; // slot still holds last lap's item, full
+			else
+				pos = enqueuePos_.load(std::memory_order_relaxed); // another producer took it
+		}
+		slot->data_ = datum;
+		slot->sequence_.store(pos + 1, std::memory_order_release); // hand to consumer
+		return true;
+	}
+
+	// try to get an element, fails if none available
+	bool Get(DataType & data)
+	{
+		auto pos = dequeuePos_.load(std::memory_order_relaxed);
+		Slot * slot;
+		for (;;)
+		{
+			slot = &slots_[RingMod::Mod1N(pos)];
+			const auto diff = static_cast<int64_t>(slot->sequence_.load(std::memory_order_acquire) - (pos + 1));
+			if (diff == 0)
+			{ // slot filled, claim it
+				if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false; // slot not yet written, empty
+			else
+				pos = dequeuePos_.load(std::memory_order_relaxed); // another consumer took it
+		}
+		data = slot->data_;
+		slot->sequence_.store(pos + N, std::memory_order_release); // hand to producer next lap
+		return true;
+	}
+
+	// try to write n elements as one run, fails if no space available
+	// claims all n positions with one CAS, so a block is never interleaved with other producers
+	bool Put(const DataType * data, std::size_t n)
+	{
+		assert(n <= N);
+		auto pos = enqueuePos_.load(std::memory_order_relaxed);
+		for (;;)
+		{ // consumers may free slots out of order, so check each one
+			const auto diff = Check(pos, n, 0);
+			if (diff == 0)
+			{
+				if (enqueuePos_.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false; // does not fit
+			else
+				pos = enqueuePos_.load(std::memory_order_relaxed);
+		}
+		for (auto i = 0U; i < n; ++i)
+		{
+			auto & slot = slots_[RingMod::Mod1N(pos + i)];
+			slot.data_ = data[i];
+			slot.sequence_.store(pos + i + 1, std::memory_order_release);
+		}
+		return true;
+	}
+
+	// try to get n elements as one run, fails if not available
+	bool Get(DataType * data, std::size_t n)
+	{
+		assert(n <= N);
+		auto pos = dequeuePos_.load(std::memory_order_relaxed);
+		for (;;)
+		{ // producers may fill slots out of order, so check each one
+			const auto diff = Check(pos, n, 1);
+			if (diff == 0)
+			{
+				if (dequeuePos_.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false; // not available
+			else
+				pos = dequeuePos_.load(std::memory_order_relaxed);
+		}
+		for (auto i = 0U; i < n; ++i)
+		{
+			auto & slot = slots_[RingMod::Mod1N(pos + i)];
+			data[i] = slot.data_;
+			slot.sequence_.store(pos + i + N, std::memory_order_release);
+		}
+		return true;
+	}
+
+private:
+	// compare sequence numbers of the n slots from pos against position + offset
+	// 0 if all match, else the first mismatch: < 0 slot not ready, > 0 position already taken
+	int64_t Check(uint64_t pos, std::size_t n, uint64_t offset) const
+	{
+		for (auto i = 0U; i < n; ++i)
+		{
+			const auto & slot = slots_[RingMod::Mod1N(pos + i)];
+			const auto diff = static_cast<int64_t>(slot.sequence_.load(std::memory_order_acquire) - (pos + i + offset));
+			if (diff != 0)
+				return diff;
+		}
+		return 0;
+	}
+
+	struct Slot
+	{
+		std::atomic<uint64_t> sequence_; // position + 0 when free for producer, + 1 when full for consumer
+		DataType data_;
+	};
+
+	// producer counter, consumer counter, slots, each on its own cache lines
+	alignas(CacheLineSize) std::atomic<uint64_t> enqueuePos_{ 0 };
+	alignas(CacheLineSize) std::atomic<uint64_t> dequeuePos_{ 0 };
+	alignas(CacheLineSize) Slot slots_[N];
+};
+
+} // namespace Lomont
+
+#endif // MPMC_RING_BUFFER_H
@@ -0,0 +1,159 @@
+#pragma once
+#ifndef MPSC_RING_BUFFER_H
+#define MPSC_RING_BUFFER_H
+
+// Multiple producer, single consumer queue built from one SPSC RingBuffer lane per producer.
+// Producer p only ever touches lane p, so the hot path is the plain SPSC path, no CAS.
+// The consumer drains the lanes, picking the next lane with a Scan policy.
+// No ordering between items from different producers, each lane is in order.
+// EACH PRODUCER MUST USE ITS OWN LANE, AND ONLY ONE CONSUMER!
+
+#include <cstdint>
+#include <cassert>
+
+#include "RingBuffer.h"
+
+namespace Lomont {
+
+/************************** lane scan variations ******************************/
+
+// Scan picks the lane for the consumer to read next, starting at lane 'start'.
+// Returns a lane with items, or lanes.size (Producers) when all are empty.
+
+// take the first non-empty lane after the last one read, each producer gets a fair share
+struct RoundRobinScan
+{
+	template<typename Lane, std::size_t Producers>
+	static std::size_t Pick(Lane(&lanes)[Producers], std::size_t start)
+	{
+		for (auto i = 0U; i < Producers; ++i)
+		{
+			auto lane = start + i < Producers ? start + i : start + i - Producers;
+			if (!lanes[lane].IsEmpty())
+				return lane;
+		}
+		return Producers;
+	}
+};
+
+// take the fullest lane, ties go to the first after the last one read
+// reads every lane's write index, so costs more per pick, but drains bursts before they stall a producer
+struct OccupancyScan
+{
+	template<typename Lane, std::size_t Producers>
+	static std::size_t Pick(Lane(&lanes)[Producers], std::size_t start)
+	{
+		std::size_t best = Producers, bestCount = 0;
+		for (auto i = 0U; i < Producers; ++i)
+		{
+			auto lane = start + i < Producers ? start + i : start + i - Producers;
+			auto count = lanes[lane].AvailableToRead();
+			if (count > bestCount)
+			{
+				best = lane;
+				bestCount = count;
+			}
+		}
+		return best;
+	}
+};
+
+// Producers lanes, each holding N items
+template<std::size_t Producers, std::size_t N, typename DataType = char, typename IndexType = int32_t, typename Scan = RoundRobinScan>
+class MpscRingBuffer
+{
+	static_assert(Producers > 0, "MpscRingBuffer needs at least one producer");
+public:
+	// padded so producers writing neighboring lanes do not share cache lines
+	using Lane = RingBuffer<N, DataType, IndexType, FastRingMod<N, IndexType>, PaddedLayout>;
+
+	// number of producer lanes
+	std::size_t Lanes() const { return Producers; }
+
+	// size of each lane, can hold exactly this many per producer
+	std::size_t Size() const { return N; }
+
+	// lane for a producer, for handles or the full ring API
+	Lane & GetLane(std::size_t producer)
+	{
+		assert(producer < Producers);
+		return lanes_[producer];
+	}
+
+	/************************** producer side, each on its own lane ******************************/
+
+	// try to write an element to the producer's lane, fails if no space available
+	bool Put(std::size_t producer, const DataType & datum)
+	{
+		assert(producer < Producers);
+		return lanes_[producer].Put(datum);
+	}
+
+#ifdef LARGE_RING_BLOCKS
+	// try to write n elements to the producer's lane, fails if no space available
+	bool Put(std::size_t producer, const DataType * data, std::size_t n)
+	{
+		assert(producer < Producers);
+		return lanes_[producer].Put(data, n);
+	}
+#endif
+
+	/************************** consumer side ******************************/
+
+	// how many items available to read over all lanes, true size may be more
+	std::size_t AvailableToRead() const
+	{
+		std::size_t count = 0;
+		for (auto & lane : lanes_)
+			count += lane.AvailableToRead();
+		return count;
+	}
+
+	bool IsEmpty() const { return AvailableToRead() == 0; }
+
+	// try to get an element from any lane, fails if all are empty
+	bool Get(DataType & data)
+	{
+		std::size_t lane;
+		return Get(data, lane);
+	}
+
+	// try to get an element from any lane, fails if all are empty, lane gets the producer
+	bool Get(DataType & data, std::size_t & lane)
+	{
+		lane = Scan::Pick(lanes_, next_);
+		if (lane == Producers)
+			return false;
+		lanes_[lane].Get(data); // only we remove, so cannot fail
+		next_ = lane + 1 < Producers ? lane + 1 : 0;
+		return true;
+	}
+
+#ifdef LARGE_RING_BLOCKS
+	// read up to n elements, all from one lane, return # read
+	// batches from a lane to amortize the scan
+	std::size_t GetSome(DataType * data, std::size_t n)
+	{
+		std::size_t lane;
+		return GetSome(data, n, lane);
+	}
+
+	// read up to n elements, all from one lane, return # read, lane gets the producer
+	std::size_t GetSome(DataType * data, std::size_t n, std::size_t & lane)
+	{
+		lane = Scan::Pick(lanes_, next_);
+		if (lane == Producers)
+			return 0;
+		next_ = lane + 1 < Producers ? lane + 1 : 0;
+		return lanes_[lane].GetSome(data, n);
+	}
+#endif
+
+private:
+	Lane lanes_[Producers];
+	std::size_t next_ = 0; // consumer only, lane after the last one read
+};
+
+} // namespace Lomont
+
+#endif // MPSC_RING_BUFFER_H
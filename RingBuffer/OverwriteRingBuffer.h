@@ -0,0 +1,177 @@
+#pragma once
+#ifndef OVERWRITE_RING_BUFFER_H
+#define OVERWRITE_RING_BUFFER_H
+
+// Single producer, single consumer lossy ring buffer for telemetry and flight recording.
+// The producer never waits or fails: when full it overwrites the oldest item, so a slow
+// or dead consumer cannot stall it. Each slot is a seqlock holding the sequence number
+// of its item, so the consumer detects being lapped and reports how many items it missed.
+// Any thread can snapshot the newest items, for example to a file after a fault.
+// MORE THREADS THAN THAT WILL NOT WORK, except for Snapshot!
+
+#include <cstdint>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <type_traits>
+
+#include "RingBuffer.h" // for CacheLineSize
+
+namespace Lomont {
+
+// start of a snapshot file, followed by count items of elementSize bytes, oldest first
+struct OverwriteSnapshotHeader
+{
+	static constexpr uint32_t Magic = 0x5057524C; // 'LRWP'
+	uint32_t magic;
+	uint32_t elementSize;
+	uint64_t count;
+	uint64_t firstSequence; // sequence number of the first item
+};
+
+template<std::size_t N, typename DataType = char>
+class OverwriteRingBuffer
+{
+	static_assert(N > 0, "OverwriteRingBuffer needs at least one slot");
+	// slots are read while they may be overwritten, then discarded if so, which only works for plain data
+	static_assert(std::is_trivially_copyable<DataType>::value, "OverwriteRingBuffer DataType must be trivially copyable");
+public:
+	OverwriteRingBuffer()
+	{
+		for (auto & slot : slots_)
+			slot.sequence_.store(0, std::memory_order_relaxed);
+	}
+
+	// size of buffer, holds the newest N items
+	std::size_t Size() const { return N; }
+
+	// total items ever written, the next item's sequence number
+	uint64_t WriteSequence() const { return writeIndex_.load(std::memory_order_acquire); }
+
+	// write an element, always succeeds, overwrites the oldest element when full
+	void Put(const DataType & datum)
+	{
+		const auto w = writeIndex_.load(std::memory_order_relaxed);
+		auto & slot = slots_[w % N];
+		slot.sequence_.store(Writing, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release); // readers see Writing before any new data
+		std::memcpy(&slot.data_, &datum, sizeof(DataType));
+		slot.sequence_.store(w + 1, std::memory_order_release); // slot holds item w, stored +1 so 0 is empty
+		writeIndex_.store(w + 1, std::memory_order_release);
+	}
+
+	// how many items available to read in [0,N], older items have been overwritten
+	std::size_t AvailableToRead() const
+	{
+		const auto count = writeIndex_.load(std::memory_order_acquire) - readIndex_;
+		return count < N ? static_cast<std::size_t>(count) : N;
+	}
+
+	bool IsEmpty() const { return AvailableToRead() == 0; }
+
+	// try to get the oldest element still held, fails if none available
+	// dropped gets how many elements were overwritten before this one could be read
+	bool Get(DataType & data, uint64_t & dropped)
+	{
+		dropped = 0;
+		for (;;)
+		{
+			const auto w = writeIndex_.load(std::memory_order_acquire);
+			if (readIndex_ == w)
+				return false; // empty
+			if (w - readIndex_ > N)
+			{ // lapped, oldest items are gone
+				dropped += w - N - readIndex_;
+				readIndex_ = w - N;
+			}
+			if (Read(readIndex_, data))
+			{
+				++readIndex_;
+				return true;
+			}
+			// producer overwrote the slot while reading, skip ahead and try again
+		}
+	}
+
+	// try to get the oldest element still held, fails if none available
+	bool Get(DataType & data)
+	{
+		uint64_t dropped;
+		return Get(data, dropped);
+	}
+
+	// sequence number of the next element to Get, call from consumer
+	uint64_t ReadSequence() const { return readIndex_; }
+
+	// copy up to the newest N elements, oldest first, from any thread without disturbing the consumer
+	// items overwritten during the copy are left out, returns # copied, firstSequence gets the first one's
+	std::size_t Snapshot(DataType * out, uint64_t & firstSequence) const
+	{
+		const auto w = writeIndex_.load(std::memory_order_acquire);
+		firstSequence = w > N ? w - N : 0;
+		std::size_t count = 0;
+		for (auto s = firstSequence; s < w; ++s)
+		{
+			if (Read(s, out[count]))
+				++count;
+			else
+			{ // overwritten while copying, so everything before it was too
+				firstSequence = s + 1;
+				count = 0;
+			}
+		}
+		return count;
+	}
+
+	// write a Snapshot to a file, header then items, for post-mortems
+	// returns false if the file cannot be written
+	bool SnapshotToFile(const char * filename) const
+	{
+		static DataType items[N]; // off the stack, may be called when it is in trouble, so not reentrant
+		OverwriteSnapshotHeader header{ OverwriteSnapshotHeader::Magic, sizeof(DataType), 0, 0 };
+		header.count = Snapshot(items, header.firstSequence);
+
+		auto file = std::fopen(filename, "wb");
+		if (file == nullptr)
+			return false;
+		auto success = std::fwrite(&header, sizeof(header), 1, file) == 1;
+		if (header.count != 0)
+			success &= std::fwrite(items, sizeof(DataType), header.count, file) == header.count;
+		success &= std::fclose(file) == 0;
+		return success;
+	}
+
+private:
+	static constexpr uint64_t Writing = ~uint64_t(0);
+
+	// seqlock read of the item with sequence number s, false if the slot no longer holds it
+	bool Read(uint64_t s, DataType & data) const
+	{
+		auto & slot = slots_[s % N];
+		if (slot.sequence_.load(std::memory_order_acquire) != s + 1)
+			return false;
+		DataType copy;
+		std::memcpy(&copy, &slot.data_, sizeof(DataType));
+		std::atomic_thread_fence(std::memory_order_acquire); // copy done before checking again
+		if (slot.sequence_.load(std::memory_order_relaxed) != s + 1)
+			return false;
+		data = copy;
+		return true;
+	}
+
+	struct Slot
+	{
+		std::atomic<uint64_t> sequence_; // item sequence + 1, 0 when empty, Writing while changing
+		DataType data_;
+	};
+
+	// producer line, slots, consumer line
+	alignas(CacheLineSize) std::atomic<uint64_t> writeIndex_{ 0 };
+	alignas(CacheLineSize) Slot slots_[N];
+	alignas(CacheLineSize) uint64_t readIndex_{ 0 }; // consumer only, producer never looks
+};
+
+} // namespace Lomont
+
+#endif // OVERWRITE_RING_BUFFER_H
@@ -0,0 +1,188 @@
+#pragma once
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// Hardware performance counters for the calling thread, read around a benchmark pass,
+// to see the cache traffic behind a throughput number, such as CacheRingBuffer's padding
+// or RingBuffer's predictive indices cutting misses.
+// Opens cycles, instructions, L1 data read misses and last level cache misses as one
+// perf_event_open group, user space only. Counters the CPU or kernel does not offer are
+// left out, and when perf events are not allowed (perf_event_paranoid, containers, VMs)
+// nothing opens and Available is false, so callers just skip the columns.
+// Counts are scaled up when the kernel multiplexed the group with other users.
+// Linux only, elsewhere nothing is available.
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Lomont {
+
+enum class Counter
+{
+	Cycles,
+	Instructions,
+	L1dMisses, // L1 data cache read misses
+	LlcMisses, // last level cache misses, for cores sharing it mostly lines moving between them
+	Count
+};
+
+constexpr int CounterCount = (int)Counter::Count;
+
+inline const char * CounterName(Counter counter)
+{
+	switch (counter)
+	{
+	case Counter::Cycles:       return "cycles";
+	case Counter::Instructions: return "instructions";
+	case Counter::L1dMisses:    return "L1D misses";
+	case Counter::LlcMisses:    return "LLC misses";
+	default:                    return "unknown";
+	}
+}
+
+// counts read over one or more intervals, summed across threads and passes
+struct CounterSample
+{
+	uint64_t values[CounterCount] = {};
+	bool valid[CounterCount] = {}; // counted in every interval added
+
+	bool Has(Counter counter) const { return valid[(int)counter]; }
+	uint64_t operator[](Counter counter) const { return values[(int)counter]; }
+
+	// add another interval, a counter stays valid only if valid in both
+	void Add(const CounterSample & other, bool first)
+	{
+		for (auto i = 0; i < CounterCount; ++i)
+		{
+			values[i] += other.values[i];
+			valid[i] = (first || valid[i]) && other.valid[i];
+		}
+	}
+};
+
+// counter group for the thread that constructs it, use only on that thread
+class PerfCounters
+{
+public:
+	PerfCounters()
+	{
+		for (auto & fd : fds_)
+			fd = -1;
+#ifdef __linux__
+		for (auto i = 0; i < CounterCount; ++i)
+		{
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			Describe((Counter)i, attr);
+			attr.disabled = leader_ < 0; // members follow the leader
+			attr.exclude_kernel = 1;     // allowed at perf_event_paranoid 2
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			// this thread, any CPU
+			const auto fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0);
+			if (fd < 0)
+				continue; // not supported or not allowed, left out
+			if (leader_ < 0)
+				leader_ = fd;
+			fds_[i] = fd;
+			order_[opened_++] = i;
+		}
+#endif
+	}
+
+	~PerfCounters()
+	{
+#ifdef __linux__
+		for (auto fd : fds_)
+			if (fd >= 0)
+				close(fd);
+#endif
+	}
+
+	PerfCounters(const PerfCounters &) = delete;
+	PerfCounters & operator=(const PerfCounters &) = delete;
+
+	// true if any counter opened
+	bool Available() const { return opened_ > 0; }
+
+	bool Has(Counter counter) const { return fds_[(int)counter] >= 0; }
+
+	// zero and start the counters
+	void Start()
+	{
+#ifdef __linux__
+		if (leader_ < 0)
+			return;
+		ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+	}
+
+	// stop the counters and return the counts since Start
+	// nothing is valid if the group never got onto the PMU
+	CounterSample Stop()
+	{
+		CounterSample sample;
+#ifdef __linux__
+		if (leader_ < 0)
+			return sample;
+		ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+		uint64_t data[3 + CounterCount]; // nr, time enabled, time running, values in open order
+		const auto bytes = read(leader_, data, sizeof(data));
+		if (bytes < (ssize_t)((3 + opened_) * sizeof(uint64_t)) || data[0] != (uint64_t)opened_ || data[2] == 0)
+			return sample;
+		const auto scale = (double)data[1] / (double)data[2]; // > 1 when multiplexed
+		for (auto j = 0; j < opened_; ++j)
+		{
+			const auto i = order_[j];
+			sample.values[i] = (uint64_t)(data[3 + j] * scale);
+			sample.valid[i] = true;
+		}
+#endif
+		return sample;
+	}
+
+private:
+#ifdef __linux__
+	// generic events, the kernel maps them to this CPU's counters
+	static void Describe(Counter counter, perf_event_attr & attr)
+	{
+		switch (counter)
+		{
+		case Counter::Cycles:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case Counter::Instructions:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case Counter::L1dMisses:
+			attr.type = PERF_TYPE_HW_CACHE; // cache id, operation, result packed in bytes
+			attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		default:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES; // the kernel's last level cache miss event
+			break;
+		}
+	}
+#endif
+
+	int fds_[CounterCount];   // by Counter, -1 if not opened
+	int order_[CounterCount]; // Counter of each group member, in open order
+	int opened_ = 0;
+	int leader_ = -1;
+};
+
+} // namespace Lomont
+
+#endif // PERF_COUNTERS_H
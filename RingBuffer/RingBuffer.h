@@ -4,6 +4,17 @@
 
 #include <cstdint>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h> // _mm_pause
+#define RING_HAS_MM_PAUSE
+#endif
 
 // Single producer, single-consumer ring buffer
 // Doesn't leave any cells empty when full, unlike many implementations.
@@ -44,6 +55,12 @@ struct SlowRingMod
 		assert(0 <= index && index < 4 * N);
 		return index % (2 * N);
 	}
+
+	// given write and read indices, return # items between them in [0,N]
+	static inline IndexType Distance(const IndexType & write, const IndexType & read)
+	{
+		return Mod2N(2 * N + write - read);
+	}
 };
 
 // instead of % for mod, utilize fact can map [0,2N-1] to [0,N] with one 'if'
@@ -69,6 +86,12 @@ struct MidRingMod
 			return index;
 		return index - 2 * N;
 	}
+
+	// given write and read indices, return # items between them in [0,N]
+	static inline IndexType Distance(const IndexType & write, const IndexType & read)
+	{
+		return Mod2N(2 * N + write - read);
+	}
 };
 
 // FastRingMod is same as MidRingMod, but with specialized power of 2 case replaced with a mask
@@ -98,27 +121,302 @@ struct FastRingModPowerOfTwo
 		assert(0 <= index && index < 4 * N);
 		return index & (2 * N - 1);
 	}
+
+	// given write and read indices, return # items between them in [0,N]
+	static inline IndexType Distance(const IndexType & write, const IndexType & read)
+	{
+		return Mod2N(2 * N + write - read);
+	}
 };
 
 // now pick based on power of 2 or not
 template<std::size_t N, typename IndexType>
 using FastRingMod = std::conditional_t<is_power_of_two<N>::value, FastRingModPowerOfTwo<N, IndexType>, MidRingMod<N, IndexType>>;
 
-template<std::size_t N, typename DataType = char, typename IndexType = int32_t, typename RingMod = FastRingMod<N, IndexType>>
-class RingBuffer
+// free running sequence numbers instead of indices kept in [0,2N-1]
+// counters only increase, so Mod2N is the identity and availability is a plain subtraction,
+// and the counters double as message ids for gap detection
+// needs a 64 bit unsigned IndexType, which will not wrap in practice
+template<std::size_t N, typename IndexType>
+struct SequenceRingMod
+{
+	static_assert(std::is_unsigned<IndexType>::value && sizeof(IndexType) >= 8, "SequenceRingMod needs a 64 bit unsigned IndexType");
+
+	// given any sequence number, return slot in [0,N-1]
+	// mask for powers of 2, else % by a constant, which compilers turn into a multiply
+	static inline IndexType Mod1N(const IndexType & index)
+	{
+		if constexpr (is_power_of_two<N>::value)
+			return index & (N - 1);
+		else
+			return index % N;
+	}
+
+	// sequence numbers are never reduced
+	static inline IndexType Mod2N(const IndexType & index)
+	{
+		return index;
+	}
+
+	// given write and read sequence numbers, return # items between them in [0,N]
+	static inline IndexType Distance(const IndexType & write, const IndexType & read)
+	{
+		return write - read;
+	}
+};
+
+/************************** layout variations ******************************/
+
+// size to align to for keeping fields used by different threads off the same cache line
+// gcc warns on every use of the library value since it varies with -mtune, so pin it there
+#if defined(__cpp_lib_hardware_interference_size) && !defined(__GNUC__)
+constexpr std::size_t CacheLineSize = std::hardware_destructive_interference_size;
+#else
+constexpr std::size_t CacheLineSize = 64;
+#endif
+
+// Each layout places the ring fields in memory. Producer owns writeIndex_ and pReadIndex_, 
+// consumer owns readIndex_ and pWriteIndex_, each side reads the other's atomic index.
+// buffer_ is uninitialized storage for N items, an item only exists from Put to Get.
+
+// fields packed in declaration order, producer fields, buffer, consumer fields
+// the buffer only separates the two sides when it spans more than a cache line
+struct PackedLayout
+{
+	template<std::size_t N, typename DataType, typename IndexType>
+	struct Fields
+	{
+		NM::atomic<IndexType> writeIndex_{ 0 };
+#ifdef LARGE_RING_BLOCKS
+		IndexType pReadIndex_{ 0 }; // predictive read index, cache neighbors
+		IndexType pendingWrites_{ 0 }; // deferred writes not yet published
+#endif
+		alignas(DataType) unsigned char buffer_[N * sizeof(DataType)]; // raw slots
+		NM::atomic<IndexType> readIndex_{ 0 };
+#ifdef LARGE_RING_BLOCKS
+		IndexType pWriteIndex_{ 0 }; // predictive write index, cache neighbors
+		IndexType pendingReads_{ 0 }; // deferred reads not yet released
+#endif
+	};
+};
+
+// same order as packed, but producer fields, buffer, and consumer fields each
+// start on their own cache line, so no sharing for any N at cost of padding
+struct PaddedLayout
+{
+	template<std::size_t N, typename DataType, typename IndexType>
+	struct Fields
+	{
+		alignas(CacheLineSize) NM::atomic<IndexType> writeIndex_{ 0 };
+#ifdef LARGE_RING_BLOCKS
+		IndexType pReadIndex_{ 0 }; // predictive read index, cache neighbors
+		IndexType pendingWrites_{ 0 }; // deferred writes not yet published
+#endif
+		alignas(CacheLineSize) alignas(DataType) unsigned char buffer_[N * sizeof(DataType)]; // raw slots
+		alignas(CacheLineSize) NM::atomic<IndexType> readIndex_{ 0 };
+#ifdef LARGE_RING_BLOCKS
+		IndexType pWriteIndex_{ 0 }; // predictive write index, cache neighbors
+		IndexType pendingReads_{ 0 }; // deferred reads not yet released
+#endif
+	};
+};
+
+// producer line and consumer line together in a header block ahead of the buffer
+// keeps all index traffic in two adjacent lines
+struct SplitLayout
+{
+	template<std::size_t N, typename DataType, typename IndexType>
+	struct Fields
+	{
+		alignas(CacheLineSize) NM::atomic<IndexType> writeIndex_{ 0 };
+#ifdef LARGE_RING_BLOCKS
+		IndexType pReadIndex_{ 0 }; // predictive read index, cache neighbors
+		IndexType pendingWrites_{ 0 }; // deferred writes not yet published
+#endif
+		alignas(CacheLineSize) NM::atomic<IndexType> readIndex_{ 0 };
+#ifdef LARGE_RING_BLOCKS
+		IndexType pWriteIndex_{ 0 }; // predictive write index, cache neighbors
+		IndexType pendingReads_{ 0 }; // deferred reads not yet released
+#endif
+		alignas(CacheLineSize) alignas(DataType) unsigned char buffer_[N * sizeof(DataType)]; // raw slots
+	};
+};
+
+/************************** wait strategies ******************************/
+
+// Used by PutWait/GetWait while the ring is full or empty. Wait(index, seen) is called 
+// while the other side's atomic index still equals seen. The other side calls 
+// Notify(index) only on an empty to non-empty or full to non-full transition,
+// and only when Parks is true, so spinning strategies add nothing to the fast path.
+// Name labels the strategy in benchmark logs.
+
+// tell the CPU this is a spin loop, saves power and helps the other hyperthread
+inline void CpuPause()
+{
+#ifdef RING_HAS_MM_PAUSE
+	_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+// spin hot, lowest latency, burns a core
+struct SpinWait
+{
+	static constexpr const char * Name = "Spin";
+	static constexpr bool Parks = false;
+	template<typename Atomic, typename Index>
+	void Wait(const Atomic &, Index) { }
+	template<typename Atomic>
+	static void Notify(Atomic &) { }
+};
+
+// spin with pause, doubling pauses each time up to a limit
+struct BackoffWait
+{
+	static constexpr const char * Name = "Backoff";
+	static constexpr bool Parks = false;
+	template<typename Atomic, typename Index>
+	void Wait(const Atomic &, Index)
+	{
+		for (auto i = 0U; i < pauses_; ++i)
+			CpuPause();
+		if (pauses_ < MaxPauses)
+			pauses_ *= 2;
+	}
+	template<typename Atomic>
+	static void Notify(Atomic &) { }
+private:
+	static constexpr unsigned MaxPauses = 1024;
+	unsigned pauses_ = 1;
+};
+
+// spin with pause a while, then give up the time slice each try
+struct YieldWait
+{
+	static constexpr const char * Name = "Yield";
+	static constexpr bool Parks = false;
+	template<typename Atomic, typename Index>
+	void Wait(const Atomic &, Index)
+	{
+		if (spins_ < MaxSpins)
+		{
+			++spins_;
+			CpuPause();
+		}
+		else
+			std::this_thread::yield();
+	}
+	template<typename Atomic>
+	static void Notify(Atomic &) { }
+private:
+	static constexpr unsigned MaxSpins = 100;
+	unsigned spins_ = 0;
+};
+
+#if defined(__cpp_lib_atomic_wait) && !defined(RL_RELACY_HPP)
+// sleep in the OS until the other side moves its index, C++20 atomic wait/notify
+struct ParkWait
+{
+	static constexpr const char * Name = "Park";
+	static constexpr bool Parks = true;
+	template<typename Atomic, typename Index>
+	void Wait(const Atomic & index, Index seen) { index.wait(seen, std::memory_order_acquire); }
+	template<typename Atomic>
+	static void Notify(Atomic & index) { index.notify_one(); }
+};
+#endif
+
+/************************** bulk copy ******************************/
+
+// copy n items between non-overlapping arrays
+// trivially copyable types use memcpy, which the C library implements 
+// with SSE/AVX kernels selected at runtime for the running CPU
+template<typename DataType>
+inline void CopyItems(DataType * dst, const DataType * src, std::size_t n)
+{
+	if constexpr (std::is_trivially_copyable<DataType>::value)
+		std::memcpy(dst, src, n * sizeof(DataType));
+	else
+		std::copy(src, src + n, dst);
+}
+
+// copy n items into uninitialized storage, constructing them
+template<typename DataType>
+inline void ConstructItems(DataType * dst, const DataType * src, std::size_t n)
+{
+	if constexpr (std::is_trivially_copyable<DataType>::value)
+		std::memcpy(dst, src, n * sizeof(DataType));
+	else
+		std::uninitialized_copy_n(src, n, dst);
+}
+
+// move n items between non-overlapping arrays, sources are left moved from
+template<typename DataType>
+inline void MoveItems(DataType * dst, DataType * src, std::size_t n)
+{
+	if constexpr (std::is_trivially_copyable<DataType>::value)
+		std::memcpy(dst, src, n * sizeof(DataType));
+	else
+		std::move(src, src + n, dst);
+}
+
+// end the lifetime of n items, nothing to do for trivial types
+template<typename DataType>
+inline void DestroyItems(DataType * items, std::size_t n)
+{
+	if constexpr (!std::is_trivially_destructible<DataType>::value)
+		std::destroy_n(items, n);
+}
+
+// up to two contiguous regions inside a ring buffer, used for zero copy access
+// second region is empty unless the items wrap past the end of the buffer
+template<typename DataType>
+struct RingSpans
+{
+	DataType * first;        // first region
+	std::size_t firstSize;   // # items in first region
+	DataType * second;       // second region, starts at front of buffer
+	std::size_t secondSize;  // # items in second region
+
+	// total items in both regions
+	std::size_t Size() const { return firstSize + secondSize; }
+};
+
+template<std::size_t N, typename DataType = char, typename IndexType = int32_t, typename RingMod = FastRingMod<N, IndexType>, typename Layout = PackedLayout>
+class RingBuffer : private Layout::template Fields<N, DataType, IndexType>
 {
 	// C++ doesn't yet support static_assert of is_always_lock_free, but may soon
 	//static_assert(std::atomic<IndexType>::is_always_lock_free, "RingbufferIndexType should be lockfree for performance");
 
 public:
 
+	RingBuffer() = default;
+
+	// destroys items still in the ring, including staged deferred writes
+	// the producer and consumer must be done with the ring
+	~RingBuffer()
+	{
+		if constexpr (!std::is_trivially_destructible<DataType>::value)
+		{
+			auto r = readIndex_.load(NM::memory_order_acquire);
+			auto w = writeIndex_.load(NM::memory_order_acquire);
+#ifdef LARGE_RING_BLOCKS
+			r = RingMod::Mod2N(r + pendingReads_); // already moved out and destroyed
+			w = RingMod::Mod2N(w + pendingWrites_);
+#endif
+			for (; r != w; r = RingMod::Mod2N(r + 1))
+				Slot(RingMod::Mod1N(r))->~DataType();
+		}
+	}
+
 	// how many items available to read in [0,N]
 	// if called from consumer, true size may be more since producer can be adding
 	// if called from producer, true size may be less since consumer may be removing
 	// undefined to call from any other thread
 	std::size_t AvailableToRead() const
 	{
-		return RingMod::Mod2N(2 * N + writeIndex_.load(NM::memory_order_acquire) - readIndex_.load(NM::memory_order_acquire));
+		return RingMod::Distance(writeIndex_.load(NM::memory_order_acquire), readIndex_.load(NM::memory_order_acquire));
 	}
 
 	// how many items available to write in [0,N]
@@ -137,15 +435,35 @@ public:
 	// size of buffer, can hold exactly this many
 	std::size_t Size() const { return N; }
 
+	// index of the next item to Put, call from producer
+	// with SequenceRingMod this counts every item ever written, so is a message id
+	IndexType WriteSequence() const { return writeIndex_.load(NM::memory_order_relaxed); }
+
+	// index of the next item to Get, call from consumer
+	// with SequenceRingMod this counts every item ever read, so is a message id
+	IndexType ReadSequence() const { return readIndex_.load(NM::memory_order_relaxed); }
+
 	// try to write an element, fails if no space available
 	bool Put(const DataType & datum)
+	{
+		return Emplace(datum);
+	}
+
+	// try to move an element in, fails if no space available, datum is untouched on failure
+	bool Put(DataType && datum)
+	{
+		return Emplace(std::move(datum));
+	}
+
+	// try to construct an element in place from args, fails if no space available
+	template<typename... Args>
+	bool Emplace(Args &&... args)
 	{ // paper above has ability to write bigger blocks, is faster
 		const auto w = writeIndex_.load(NM::memory_order_relaxed);
-		const auto nextWrite = RingMod::Mod2N(w + 1);
-		if (nextWrite != readIndex_.load(NM::memory_order_acquire))
+		if (RingMod::Distance(w, readIndex_.load(NM::memory_order_acquire)) != N) // full when read index is N behind
 		{
-			buffer_[RingMod::Mod1N(w)] = datum;
-			writeIndex_.store(nextWrite, NM::memory_order_release);
+			::new (static_cast<void*>(Slot(RingMod::Mod1N(w)))) DataType(std::forward<Args>(args)...);
+			writeIndex_.store(RingMod::Mod2N(w + 1), NM::memory_order_release);
 			return true;
 		}
 		// buffer full
@@ -158,27 +476,82 @@ public:
 		const auto r = readIndex_.load(NM::memory_order_relaxed);
 		if (r != writeIndex_.load(NM::memory_order_acquire))
 		{
-			data = buffer_[RingMod::Mod1N(r)];
+			MoveOut(data, RingMod::Mod1N(r));
 			readIndex_.store(RingMod::Mod2N(r + 1), NM::memory_order_release);
 			return true;
 		}
 		return false; // buffer empty
 	}
 
+	// write an element, waiting while full using the Wait strategy
+	template<typename Wait = SpinWait>
+	void PutWait(const DataType & datum)
+	{
+		const auto w = writeIndex_.load(NM::memory_order_relaxed);
+		auto r = readIndex_.load(NM::memory_order_acquire);
+		if (RingMod::Distance(w, r) == N) // full
+		{
+			Wait wait;
+			do
+			{
+				wait.Wait(readIndex_, r);
+				r = readIndex_.load(NM::memory_order_acquire);
+			} while (RingMod::Distance(w, r) == N);
+		}
+		::new (static_cast<void*>(Slot(RingMod::Mod1N(w)))) DataType(datum);
+		writeIndex_.store(RingMod::Mod2N(w + 1), NM::memory_order_release);
+		if constexpr (Wait::Parks)
+		{ // consumer may be parked only if it had caught up, ring was empty
+			NM::atomic_thread_fence(NM::memory_order_seq_cst); // pairs with fence in GetWait
+			if (readIndex_.load(NM::memory_order_relaxed) == w)
+				Wait::Notify(writeIndex_);
+		}
+	}
+
+	// get an element, waiting while empty using the Wait strategy
+	template<typename Wait = SpinWait>
+	void GetWait(DataType & data)
+	{
+		const auto r = readIndex_.load(NM::memory_order_relaxed);
+		auto w = writeIndex_.load(NM::memory_order_acquire);
+		if (w == r)
+		{
+			Wait wait;
+			if constexpr (Wait::Parks)
+			{ // order our last read index store before the check, pairs with fence in PutWait
+				NM::atomic_thread_fence(NM::memory_order_seq_cst);
+				w = writeIndex_.load(NM::memory_order_acquire);
+			}
+			while (w == r)
+			{
+				wait.Wait(writeIndex_, w);
+				w = writeIndex_.load(NM::memory_order_acquire);
+			}
+		}
+		MoveOut(data, RingMod::Mod1N(r));
+		readIndex_.store(RingMod::Mod2N(r + 1), NM::memory_order_release);
+		if constexpr (Wait::Parks)
+		{ // producer may be parked only if ring was full
+			NM::atomic_thread_fence(NM::memory_order_seq_cst); // pairs with fence in PutWait
+			if (RingMod::Distance(writeIndex_.load(NM::memory_order_relaxed), r) == N)
+				Wait::Notify(readIndex_);
+		}
+	}
+
 #ifdef LARGE_RING_BLOCKS
 	// try to write n elements, fails if no space available
 	bool Put(const DataType * data, std::size_t n)
 	{
 		auto w = writeIndex_.load(NM::memory_order_relaxed);
-		if (Size() - RingMod::Mod2N(2 * N + w - pReadIndex_) < n) // predicted available to write
+		if (Size() - RingMod::Distance(w, pReadIndex_) < n) // predicted available to write
 		{ // may not fit, check more exactly, costing an atomic read
 			pReadIndex_ = readIndex_.load(NM::memory_order_acquire);
-			if (Size() - RingMod::Mod2N(2 * N + w - pReadIndex_) < n) // current available to write
+			if (Size() - RingMod::Distance(w, pReadIndex_) < n) // current available to write
 				return false; // does not fit
 		}
-		auto t = RingMod::Mod1N(w);
-		for (auto i = 0; i < n; ++i)
-			buffer_[RingMod::Mod1N(t+i)] = data[i];   
+		auto spans = MakeSpans(RingMod::Mod1N(w), n); // at most two pieces, split at wrap
+		ConstructItems(spans.first, data, spans.firstSize);
+		ConstructItems(spans.second, data + spans.firstSize, spans.secondSize);
 		w = RingMod::Mod2N(w + n);
 		writeIndex_.store(w, NM::memory_order_release);
 		return true;
@@ -188,39 +561,449 @@ public:
 	bool Get(DataType * data, std::size_t n)
 	{
 		auto r = readIndex_.load(NM::memory_order_relaxed);
-		if (RingMod::Mod2N(2 * N + pWriteIndex_ - r) < n) // predicted available to read
+		if ((std::size_t)RingMod::Distance(pWriteIndex_, r) < n) // predicted available to read
 		{ // may not fit, check more exactly, costing an atomic read
 			pWriteIndex_ = writeIndex_.load(NM::memory_order_acquire);
-			if (RingMod::Mod2N(2 * N + pWriteIndex_ - r) < n) // current available to read
+			if ((std::size_t)RingMod::Distance(pWriteIndex_, r) < n) // current available to read
 				return false; // not available
 		}
-		auto t = RingMod::Mod1N(r);
-		for (auto i = 0; i < n; ++i)
-			data[i] = buffer_[RingMod::Mod1N(t+i)];
+		auto spans = MakeSpans(RingMod::Mod1N(r), n); // at most two pieces, split at wrap
+		MoveItems(data, spans.first, spans.firstSize);
+		MoveItems(data + spans.firstSize, spans.second, spans.secondSize);
+		DestroyItems(spans.first, spans.firstSize);
+		DestroyItems(spans.second, spans.secondSize);
 		r = RingMod::Mod2N(r + n);
 		readIndex_.store(r, NM::memory_order_release);
 		return true;
 	}
+
+	// write as many of the n elements as fit, return # written
+	// costs at most one atomic read of the read index, none when prediction shows room
+	std::size_t PutSome(const DataType * data, std::size_t n)
+	{
+		auto spans = ReserveWrite(n);
+		if (spans.Size() == 0)
+			return 0; // full
+		ConstructItems(spans.first, data, spans.firstSize);
+		ConstructItems(spans.second, data + spans.firstSize, spans.secondSize);
+		CommitWrite(spans.Size());
+		return spans.Size();
+	}
+
+	// read as many of n elements as available, return # read
+	// costs at most one atomic read of the write index, none when prediction shows enough
+	std::size_t GetSome(DataType * data, std::size_t n)
+	{
+		auto spans = ReserveRead(n);
+		if (spans.Size() == 0)
+			return 0; // empty
+		MoveItems(data, spans.first, spans.firstSize);
+		MoveItems(data + spans.firstSize, spans.second, spans.secondSize);
+		ReleaseRead(spans.Size()); // destroys moved from items
+		return spans.Size();
+	}
+
+	// write an element, publishing the write index only every K elements or on Flush,
+	// so the index cache line moves to the consumer once per K elements instead of each one
+	// consumer cannot see staged items until published, a full ring publishes them
+	// producer must Flush when done, and before mixing with other producer calls
+	template<std::size_t K>
+	bool PutDeferred(const DataType & datum)
+	{
+		static_assert(0 < K && K <= N, "Batch size must be in [1,N]");
+		const auto w = RingMod::Mod2N(writeIndex_.load(NM::memory_order_relaxed) + pendingWrites_);
+		if (RingMod::Distance(w, pReadIndex_) == N) // predicted full
+		{ // may be full, check more exactly, costing an atomic read
+			pReadIndex_ = readIndex_.load(NM::memory_order_acquire);
+			if (RingMod::Distance(w, pReadIndex_) == N)
+			{
+				Flush(); // let consumer drain what is staged
+				return false;
+			}
+		}
+		::new (static_cast<void*>(Slot(RingMod::Mod1N(w)))) DataType(datum);
+		if (++pendingWrites_ == K)
+			Flush();
+		return true;
+	}
+
+	// publish any writes staged by PutDeferred
+	void Flush()
+	{
+		if (pendingWrites_ == 0)
+			return;
+		const auto w = writeIndex_.load(NM::memory_order_relaxed);
+		writeIndex_.store(RingMod::Mod2N(w + pendingWrites_), NM::memory_order_release);
+		pendingWrites_ = 0;
+	}
+
+	// get an element, releasing the read index only every K elements or on FlushRead
+	// an empty ring releases staged reads, so a spinning producer always makes progress
+	// consumer should FlushRead before mixing with other consumer calls
+	template<std::size_t K>
+	bool GetDeferred(DataType & data)
+	{
+		static_assert(0 < K && K <= N, "Batch size must be in [1,N]");
+		const auto r = RingMod::Mod2N(readIndex_.load(NM::memory_order_relaxed) + pendingReads_);
+		if (r == pWriteIndex_) // predicted empty
+		{ // may be empty, check more exactly, costing an atomic read
+			pWriteIndex_ = writeIndex_.load(NM::memory_order_acquire);
+			if (r == pWriteIndex_)
+			{
+				FlushRead(); // give producer the space
+				return false;
+			}
+		}
+		MoveOut(data, RingMod::Mod1N(r));
+		if (++pendingReads_ == K)
+			FlushRead();
+		return true;
+	}
+
+	// release any reads staged by GetDeferred
+	void FlushRead()
+	{
+		if (pendingReads_ == 0)
+			return;
+		const auto r = readIndex_.load(NM::memory_order_relaxed);
+		readIndex_.store(RingMod::Mod2N(r + pendingReads_), NM::memory_order_release);
+		pendingReads_ = 0;
+	}
+
+	// zero copy write, producer only: reserve up to n slots to fill in place
+	// returned spans hold fewer than n items if not enough room, none when full
+	// fill them, then CommitWrite at most that many items to publish them
+	// slots are uninitialized, non trivial types must be constructed in them with placement new
+	RingSpans<DataType> ReserveWrite(std::size_t n)
+	{
+		const auto w = writeIndex_.load(NM::memory_order_relaxed);
+		auto available = Size() - RingMod::Distance(w, pReadIndex_); // predicted available to write
+		if (available < n)
+		{ // may not fit, check more exactly, costing an atomic read
+			pReadIndex_ = readIndex_.load(NM::memory_order_acquire);
+			available = Size() - RingMod::Distance(w, pReadIndex_);
+		}
+		return MakeSpans(RingMod::Mod1N(w), n < available ? n : available);
+	}
+
+	// publish n items written into spans from ReserveWrite
+	void CommitWrite(std::size_t n)
+	{
+		const auto w = writeIndex_.load(NM::memory_order_relaxed);
+		assert(n <= Size() - RingMod::Distance(w, pReadIndex_));
+		writeIndex_.store(RingMod::Mod2N(w + n), NM::memory_order_release);
+	}
+
+	// zero copy read, consumer only: get spans to up to n items in place
+	// returned spans hold fewer than n items if not available, none when empty
+	// use them, then ReleaseRead at most that many items to destroy them and free the slots
+	RingSpans<DataType> ReserveRead(std::size_t n)
+	{
+		const auto r = readIndex_.load(NM::memory_order_relaxed);
+		auto available = (std::size_t)RingMod::Distance(pWriteIndex_, r); // predicted available to read
+		if (available < n)
+		{ // may not be available, check more exactly, costing an atomic read
+			pWriteIndex_ = writeIndex_.load(NM::memory_order_acquire);
+			available = (std::size_t)RingMod::Distance(pWriteIndex_, r);
+		}
+		return MakeSpans(RingMod::Mod1N(r), n < available ? n : available);
+	}
+
+	// release n items read from spans from ReserveRead
+	void ReleaseRead(std::size_t n)
+	{
+		const auto r = readIndex_.load(NM::memory_order_relaxed);
+		assert(n <= (std::size_t)RingMod::Distance(pWriteIndex_, r));
+		if constexpr (!std::is_trivially_destructible<DataType>::value)
+		{
+			auto spans = MakeSpans(RingMod::Mod1N(r), n);
+			DestroyItems(spans.first, spans.firstSize);
+			DestroyItems(spans.second, spans.secondSize);
+		}
+		readIndex_.store(RingMod::Mod2N(r + n), NM::memory_order_release);
+	}
+
+	// look at up to n items in place without consuming them, consumer only
+	// returned spans hold fewer than n items if not available, items stay until Skip or a Get
+	RingSpans<const DataType> Peek(std::size_t n)
+	{
+		const auto spans = ReserveRead(n);
+		return { spans.first, spans.firstSize, spans.second, spans.secondSize };
+	}
+
+	// discard up to n items without copying them out, consumer only, return # skipped
+	std::size_t Skip(std::size_t n)
+	{
+		const auto skipped = ReserveRead(n).Size();
+		if (skipped != 0)
+			ReleaseRead(skipped);
+		return skipped;
+	}
+
+	// consume every available item in place, consumer only, return # consumed
+	// calls fn(items, count) on each contiguous segment, at most two, then frees them all
+	// with one release of the read index, so costs at most two atomic operations per call
+	// fn must not keep pointers to the items
+	template<typename Func>
+	std::size_t ConsumeAll(Func && fn)
+	{
+		const auto spans = ReserveRead(Size()); // everything available
+		if (spans.firstSize == 0)
+			return 0; // empty
+		fn(static_cast<const DataType*>(spans.first), spans.firstSize);
+		if (spans.secondSize != 0)
+			fn(static_cast<const DataType*>(spans.second), spans.secondSize);
+		ReleaseRead(spans.Size());
+		return spans.Size();
+	}
 #endif
+
+	// Producer side of the ring, only one exists at a time, use from the producer thread.
+	// Keeps its own write index in a plain local and a cached view of the read index, 
+	// so queries cost at most one atomic load, and consumer calls do not compile.
+	// Do not mix with producer calls on the ring itself while it exists.
+	class ProducerHandle
+	{
+	public:
+		ProducerHandle(ProducerHandle && other) noexcept : ring_(other.ring_), write_(other.write_), read_(other.read_)
+		{
+			other.ring_ = nullptr;
+		}
+		ProducerHandle(const ProducerHandle &) = delete;
+		ProducerHandle & operator=(const ProducerHandle &) = delete;
+		ProducerHandle & operator=(ProducerHandle &&) = delete;
+
+		~ProducerHandle()
+		{
+			if (ring_ != nullptr)
+				ring_->producerOut_ = false;
+		}
+
+		// false if MakeProducer refused this handle, or it was moved from, then use no other calls
+		bool Valid() const { return ring_ != nullptr; }
+
+		// how many items can be written in [0,N], true size may be more since consumer may be removing
+		// one atomic load
+		std::size_t AvailableToWrite()
+		{
+			read_ = ring_->readIndex_.load(NM::memory_order_acquire);
+			return N - RingMod::Distance(write_, read_);
+		}
+
+		bool IsFull() { return AvailableToWrite() == 0; }
+
+		// size of buffer, can hold exactly this many
+		std::size_t Size() const { return N; }
+
+		// try to write an element, fails if no space available
+		bool Put(const DataType & datum)
+		{
+			if (RingMod::Distance(write_, read_) == N) // predicted full
+			{ // may be full, check more exactly, costing an atomic read
+				read_ = ring_->readIndex_.load(NM::memory_order_acquire);
+				if (RingMod::Distance(write_, read_) == N)
+					return false;
+			}
+			::new (static_cast<void*>(ring_->Slot(RingMod::Mod1N(write_)))) DataType(datum);
+			write_ = RingMod::Mod2N(write_ + 1);
+			ring_->writeIndex_.store(write_, NM::memory_order_release);
+			return true;
+		}
+
+#ifdef LARGE_RING_BLOCKS
+		// try to write n elements, fails if no space available
+		bool Put(const DataType * data, std::size_t n)
+		{
+			if (N - RingMod::Distance(write_, read_) < n) // predicted available to write
+			{ // may not fit, check more exactly, costing an atomic read
+				read_ = ring_->readIndex_.load(NM::memory_order_acquire);
+				if (N - RingMod::Distance(write_, read_) < n)
+					return false; // does not fit
+			}
+			auto spans = ring_->MakeSpans(RingMod::Mod1N(write_), n);
+			ConstructItems(spans.first, data, spans.firstSize);
+			ConstructItems(spans.second, data + spans.firstSize, spans.secondSize);
+			write_ = RingMod::Mod2N(write_ + n);
+			ring_->writeIndex_.store(write_, NM::memory_order_release);
+			return true;
+		}
+#endif
+
+	private:
+		friend class RingBuffer;
+		explicit ProducerHandle(RingBuffer & ring) :
+			ring_(&ring),
+			write_(ring.writeIndex_.load(NM::memory_order_relaxed)),
+			read_(ring.readIndex_.load(NM::memory_order_acquire))
+		{
+		}
+
+		ProducerHandle() : ring_(nullptr), write_(0), read_(0) { } // refused, not Valid
+
+		RingBuffer * ring_;
+		IndexType write_; // our index, published to ring after each change
+		IndexType read_;  // last seen consumer index, behind the true one
+	};
+
+	// Consumer side of the ring, only one exists at a time, use from the consumer thread.
+	// Keeps its own read index in a plain local and a cached view of the write index, 
+	// so queries cost at most one atomic load, and producer calls do not compile.
+	// Do not mix with consumer calls on the ring itself while it exists.
+	class ConsumerHandle
+	{
+	public:
+		ConsumerHandle(ConsumerHandle && other) noexcept : ring_(other.ring_), read_(other.read_), write_(other.write_)
+		{
+			other.ring_ = nullptr;
+		}
+		ConsumerHandle(const ConsumerHandle &) = delete;
+		ConsumerHandle & operator=(const ConsumerHandle &) = delete;
+		ConsumerHandle & operator=(ConsumerHandle &&) = delete;
+
+		~ConsumerHandle()
+		{
+			if (ring_ != nullptr)
+				ring_->consumerOut_ = false;
+		}
+
+		// false if MakeConsumer refused this handle, or it was moved from, then use no other calls
+		bool Valid() const { return ring_ != nullptr; }
+
+		// how many items can be read in [0,N], true size may be more since producer may be adding
+		// one atomic load
+		std::size_t AvailableToRead()
+		{
+			write_ = ring_->writeIndex_.load(NM::memory_order_acquire);
+			return RingMod::Distance(write_, read_);
+		}
+
+		bool IsEmpty() { return AvailableToRead() == 0; }
+
+		// size of buffer, can hold exactly this many
+		std::size_t Size() const { return N; }
+
+		// try to get an element, fails if none available
+		bool Get(DataType & data)
+		{
+			if (read_ == write_) // predicted empty
+			{ // may be empty, check more exactly, costing an atomic read
+				write_ = ring_->writeIndex_.load(NM::memory_order_acquire);
+				if (read_ == write_)
+					return false;
+			}
+			ring_->MoveOut(data, RingMod::Mod1N(read_));
+			read_ = RingMod::Mod2N(read_ + 1);
+			ring_->readIndex_.store(read_, NM::memory_order_release);
+			return true;
+		}
+
+#ifdef LARGE_RING_BLOCKS
+		// try to get n elements, fails if not available
+		bool Get(DataType * data, std::size_t n)
+		{
+			if ((std::size_t)RingMod::Distance(write_, read_) < n) // predicted available to read
+			{ // may not be available, check more exactly, costing an atomic read
+				write_ = ring_->writeIndex_.load(NM::memory_order_acquire);
+				if ((std::size_t)RingMod::Distance(write_, read_) < n)
+					return false; // not available
+			}
+			auto spans = ring_->MakeSpans(RingMod::Mod1N(read_), n);
+			MoveItems(data, spans.first, spans.firstSize);
+			MoveItems(data + spans.firstSize, spans.second, spans.secondSize);
+			DestroyItems(spans.first, spans.firstSize);
+			DestroyItems(spans.second, spans.secondSize);
+			read_ = RingMod::Mod2N(read_ + n);
+			ring_->readIndex_.store(read_, NM::memory_order_release);
+			return true;
+		}
+#endif
+
+	private:
+		friend class RingBuffer;
+		explicit ConsumerHandle(RingBuffer & ring) :
+			ring_(&ring),
+			read_(ring.readIndex_.load(NM::memory_order_relaxed)),
+			write_(ring.writeIndex_.load(NM::memory_order_acquire))
+		{
+		}
+
+		ConsumerHandle() : ring_(nullptr), read_(0), write_(0) { } // refused, not Valid
+
+		RingBuffer * ring_;
+		IndexType read_;  // our index, published to ring after each change
+		IndexType write_; // last seen producer index, behind the true one
+	};
+
+	// get the producer handle, only one may exist at a time
+	// while one exists, returns a handle that is not Valid, in all builds
+	ProducerHandle MakeProducer()
+	{
+		if (producerOut_)
+			return ProducerHandle();
+		producerOut_ = true;
+		return ProducerHandle(*this);
+	}
+
+	// get the consumer handle, only one may exist at a time
+	// while one exists, returns a handle that is not Valid, in all builds
+	ConsumerHandle MakeConsumer()
+	{
+		if (consumerOut_)
+			return ConsumerHandle();
+		consumerOut_ = true;
+		return ConsumerHandle(*this);
+	}
+
 private:
+#ifdef LARGE_RING_BLOCKS
+	// spans covering n items starting at buffer position t in [0,N-1], split at the end of the buffer
+	RingSpans<DataType> MakeSpans(std::size_t t, std::size_t n)
+	{
+		const auto firstSize = n < N - t ? n : N - t;
+		return { Slot(t), firstSize, Slot(0), n - firstSize };
+	}
+#endif
+
+	// slot t in [0,N-1], raw storage unless an item is live there
+	DataType * Slot(std::size_t t)
+	{
+		return reinterpret_cast<DataType*>(buffer_) + t;
+	}
+
+	// move the item in slot t out to data and end its lifetime
+	void MoveOut(DataType & data, std::size_t t)
+	{
+		auto item = Slot(t);
+		data = std::move(*item);
+		item->~DataType();
+	}
+
 	// Taking counters mod N leaves one cell unused without additional fields to track, 
 	// but then atomic operations harder to check.
 	// Taking counters mod 2N makes it possible to use all cells in the buffer when full, 
 	// at additional cost of bound enforcement on buffer access.
 
-	// try to cache separate read and write. Can do better, but at increased space
-	NM::atomic<IndexType> writeIndex_{ 0 };
+	// try to cache separate read and write, Layout picks the placement in memory
+	using Fields = typename Layout::template Fields<N, DataType, IndexType>;
+	using Fields::writeIndex_;
+	using Fields::buffer_;
+	using Fields::readIndex_;
 #ifdef LARGE_RING_BLOCKS
-	IndexType pReadIndex_{ 0 }; // predictive read index, cache neighbors
-#endif
-	DataType buffer_[N];
-	NM::atomic<IndexType> readIndex_{ 0 };
-#ifdef LARGE_RING_BLOCKS
-	IndexType pWriteIndex_{ 0 }; // predictive write index, cache neighbors
+	using Fields::pReadIndex_;
+	using Fields::pWriteIndex_;
+	using Fields::pendingWrites_;
+	using Fields::pendingReads_;
 #endif
 
+	// handles handed out, each set and cleared only by its own side
+	bool producerOut_ = false;
+	bool consumerOut_ = false;
 };
 
+// ring using free running 64 bit sequence numbers for indices
+template<std::size_t N, typename DataType = char, typename Layout = PackedLayout>
+using SequenceRingBuffer = RingBuffer<N, DataType, uint64_t, SequenceRingMod<N, uint64_t>, Layout>;
+
 #undef NM
 #undef ACCESS
 
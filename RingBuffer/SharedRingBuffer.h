@@ -0,0 +1,338 @@
+#pragma once
+#ifndef SHARED_RING_BUFFER_H
+#define SHARED_RING_BUFFER_H
+
+// Single producer, single consumer ring buffer living in a shared memory segment, so the
+// producer and consumer can be in different processes. One process creates the segment,
+// the other attaches to it. All shared state is in the segment, found by offsets from a
+// versioned header, so it works at any mapping address. Indices are free running 64 bit
+// counters in lock free atomics, each on its own cache line.
+// Linux only, uses shm_open or a memfd, and mmap.
+// MORE THREADS THAN THAT WILL NOT WORK!
+
+#ifdef __linux__
+
+#include <cstdint>
+#include <cassert>
+#include <cerrno>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "RingBuffer.h" // for CopyItems, RingSpans, CacheLineSize
+
+namespace Lomont {
+
+// start of every segment, the only thing at a fixed place
+// offsets are from the start of the segment
+struct SharedRingHeader
+{
+	static constexpr uint32_t Magic = 0x474E524C; // 'LRNG'
+	static constexpr uint32_t Version = 1;
+
+	uint32_t magic;
+	uint32_t version;
+	uint32_t elementSize;   // sizeof(DataType)
+	uint32_t layout;        // 0: write index line, read index line, data, each cache line aligned
+	uint64_t capacity;      // items
+	uint64_t writeOffset;   // std::atomic<uint64_t> write index
+	uint64_t readOffset;    // std::atomic<uint64_t> read index
+	uint64_t dataOffset;    // first item
+	uint64_t segmentBytes;  // total size
+	std::atomic<uint32_t> ready; // set last by the creator, attach fails until then
+};
+
+template<typename DataType = char>
+class SharedRingBuffer
+{
+	static_assert(std::is_trivially_copyable<DataType>::value, "SharedRingBuffer DataType must be trivially copyable");
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "SharedRingBuffer needs lock free 64 bit atomics to share across processes");
+	static_assert(std::atomic<uint32_t>::is_always_lock_free, "SharedRingBuffer needs lock free 32 bit atomics to share across processes");
+public:
+	// create a named segment with shm_open, fails if the name exists
+	// the creator unlinks the name when destroyed
+	static SharedRingBuffer Create(const std::string & name, std::size_t capacity)
+	{
+		const auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (fd < 0)
+			throw std::system_error(errno, std::generic_category(), "shm_open");
+		try
+		{
+			auto ring = Create(fd, capacity);
+			close(fd);
+			ring.name_ = name;
+			return ring;
+		}
+		catch (...)
+		{
+			close(fd);
+			shm_unlink(name.c_str());
+			throw;
+		}
+	}
+
+	// attach to a named segment made by Create
+	static SharedRingBuffer Attach(const std::string & name)
+	{
+		const auto fd = shm_open(name.c_str(), O_RDWR, 0);
+		if (fd < 0)
+			throw std::system_error(errno, std::generic_category(), "shm_open");
+		try
+		{
+			auto ring = Attach(fd);
+			close(fd);
+			return ring;
+		}
+		catch (...)
+		{
+			close(fd);
+			throw;
+		}
+	}
+
+	// size an empty file descriptor, such as from memfd_create, and lay out the ring in it
+	// caller keeps ownership of fd, the mapping stays valid after it is closed
+	static SharedRingBuffer Create(int fd, std::size_t capacity)
+	{
+		if (capacity == 0)
+			throw std::invalid_argument("SharedRingBuffer size must be positive");
+		const auto writeOffset = RoundUp(sizeof(SharedRingHeader));
+		const auto readOffset = writeOffset + CacheLineSize;
+		const auto dataOffset = readOffset + CacheLineSize;
+		const auto segmentBytes = dataOffset + RoundUp(capacity * sizeof(DataType));
+		if (ftruncate(fd, static_cast<off_t>(segmentBytes)) != 0)
+			throw std::system_error(errno, std::generic_category(), "ftruncate");
+
+		SharedRingBuffer ring(Map(fd, segmentBytes), segmentBytes);
+		auto header = ring.header_;
+		header->magic = SharedRingHeader::Magic;
+		header->version = SharedRingHeader::Version;
+		header->elementSize = sizeof(DataType);
+		header->layout = 0;
+		header->capacity = capacity;
+		header->writeOffset = writeOffset;
+		header->readOffset = readOffset;
+		header->dataOffset = dataOffset;
+		header->segmentBytes = segmentBytes;
+		new (ring.base_ + writeOffset) std::atomic<uint64_t>(0);
+		new (ring.base_ + readOffset) std::atomic<uint64_t>(0);
+		ring.Bind();
+		header->ready.store(1, std::memory_order_release); // publish header to attachers
+		return ring;
+	}
+
+	// attach to a file descriptor laid out by Create, checking the header matches this DataType
+	static SharedRingBuffer Attach(int fd)
+	{
+		struct stat info;
+		if (fstat(fd, &info) != 0)
+			throw std::system_error(errno, std::generic_category(), "fstat");
+		const auto bytes = static_cast<std::size_t>(info.st_size);
+		if (bytes < sizeof(SharedRingHeader))
+			throw std::runtime_error("SharedRingBuffer segment too small");
+
+		SharedRingBuffer ring(Map(fd, bytes), bytes);
+		const auto header = ring.header_;
+		if (header->ready.load(std::memory_order_acquire) != 1)
+			throw std::runtime_error("SharedRingBuffer segment not ready");
+		if (header->magic != SharedRingHeader::Magic)
+			throw std::runtime_error("SharedRingBuffer segment has wrong magic");
+		if (header->version != SharedRingHeader::Version || header->layout != 0)
+			throw std::runtime_error("SharedRingBuffer segment has unsupported version");
+		if (header->elementSize != sizeof(DataType))
+			throw std::runtime_error("SharedRingBuffer segment has wrong element size");
+		if (header->segmentBytes != bytes ||
+			header->writeOffset + sizeof(std::atomic<uint64_t>) > bytes ||
+			header->readOffset + sizeof(std::atomic<uint64_t>) > bytes ||
+			header->dataOffset + header->capacity * sizeof(DataType) > bytes ||
+			header->capacity == 0)
+			throw std::runtime_error("SharedRingBuffer segment has bad offsets");
+		ring.Bind();
+		return ring;
+	}
+
+	SharedRingBuffer(SharedRingBuffer && other) noexcept :
+		base_(other.base_), bytes_(other.bytes_), name_(std::move(other.name_)),
+		header_(other.header_), writeIndex_(other.writeIndex_), readIndex_(other.readIndex_),
+		buffer_(other.buffer_), size_(other.size_), isPowerOfTwo_(other.isPowerOfTwo_),
+		pReadIndex_(other.pReadIndex_), pWriteIndex_(other.pWriteIndex_)
+	{
+		other.base_ = nullptr;
+		other.name_.clear();
+	}
+
+	SharedRingBuffer(const SharedRingBuffer &) = delete;
+	SharedRingBuffer & operator=(const SharedRingBuffer &) = delete;
+	SharedRingBuffer & operator=(SharedRingBuffer &&) = delete;
+
+	~SharedRingBuffer()
+	{
+		if (base_ != nullptr)
+			munmap(base_, bytes_);
+		if (!name_.empty())
+			shm_unlink(name_.c_str());
+	}
+
+	// how many items available to read in [0,Size]
+	// if called from consumer, true size may be more since producer can be adding
+	// if called from producer, true size may be less since consumer may be removing
+	std::size_t AvailableToRead() const
+	{
+		return writeIndex_->load(std::memory_order_acquire) - readIndex_->load(std::memory_order_acquire);
+	}
+
+	// how many items available to write in [0,Size]
+	// if called from consumer, true size may be less since producer can be adding
+	// if called from producer, true size may be more since consumer may be removing
+	std::size_t AvailableToWrite() const
+	{
+		return Size() - AvailableToRead();
+	}
+
+	bool IsEmpty() const { return AvailableToRead() == 0; }
+
+	bool IsFull()  const { return AvailableToRead() == Size(); }
+
+	// size of buffer, can hold exactly this many
+	std::size_t Size() const { return size_; }
+
+	// try to write an element, fails if no space available
+	bool Put(const DataType & datum)
+	{
+		const auto w = writeIndex_->load(std::memory_order_relaxed);
+		if (w - pReadIndex_ == size_) // predicted full
+		{ // may be full, check more exactly, costing an atomic read
+			pReadIndex_ = readIndex_->load(std::memory_order_acquire);
+			if (w - pReadIndex_ == size_)
+				return false;
+		}
+		buffer_[Mod1N(w)] = datum;
+		writeIndex_->store(w + 1, std::memory_order_release);
+		return true;
+	}
+
+	// try to get an element, fails if none available
+	bool Get(DataType & data)
+	{
+		const auto r = readIndex_->load(std::memory_order_relaxed);
+		if (r == pWriteIndex_) // predicted empty
+		{ // may be empty, check more exactly, costing an atomic read
+			pWriteIndex_ = writeIndex_->load(std::memory_order_acquire);
+			if (r == pWriteIndex_)
+				return false;
+		}
+		data = buffer_[Mod1N(r)];
+		readIndex_->store(r + 1, std::memory_order_release);
+		return true;
+	}
+
+	// try to write n elements, fails if no space available
+	bool Put(const DataType * data, std::size_t n)
+	{
+		const auto w = writeIndex_->load(std::memory_order_relaxed);
+		if (size_ - (w - pReadIndex_) < n) // predicted available to write
+		{ // may not fit, check more exactly, costing an atomic read
+			pReadIndex_ = readIndex_->load(std::memory_order_acquire);
+			if (size_ - (w - pReadIndex_) < n)
+				return false; // does not fit
+		}
+		auto spans = MakeSpans(Mod1N(w), n); // at most two pieces, split at wrap
+		CopyItems(spans.first, data, spans.firstSize);
+		CopyItems(spans.second, data + spans.firstSize, spans.secondSize);
+		writeIndex_->store(w + n, std::memory_order_release);
+		return true;
+	}
+
+	// try to get n elements, fails if not available
+	bool Get(DataType * data, std::size_t n)
+	{
+		const auto r = readIndex_->load(std::memory_order_relaxed);
+		if (pWriteIndex_ - r < n) // predicted available to read
+		{ // may not be available, check more exactly, costing an atomic read
+			pWriteIndex_ = writeIndex_->load(std::memory_order_acquire);
+			if (pWriteIndex_ - r < n)
+				return false; // not available
+		}
+		auto spans = MakeSpans(Mod1N(r), n); // at most two pieces, split at wrap
+		CopyItems(data, spans.first, spans.firstSize);
+		CopyItems(data + spans.firstSize, spans.second, spans.secondSize);
+		readIndex_->store(r + n, std::memory_order_release);
+		return true;
+	}
+
+private:
+	SharedRingBuffer(char * base, std::size_t bytes) :
+		base_(base), bytes_(bytes), header_(reinterpret_cast<SharedRingHeader*>(base))
+	{
+	}
+
+	static std::size_t RoundUp(std::size_t bytes)
+	{
+		return (bytes + CacheLineSize - 1) & ~(CacheLineSize - 1);
+	}
+
+	static char * Map(int fd, std::size_t bytes)
+	{
+		auto p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED)
+			throw std::system_error(errno, std::generic_category(), "mmap");
+		return static_cast<char*>(p);
+	}
+
+	// find the shared state from the header offsets, this process' addresses only live here
+	void Bind()
+	{
+		writeIndex_ = reinterpret_cast<std::atomic<uint64_t>*>(base_ + header_->writeOffset);
+		readIndex_ = reinterpret_cast<std::atomic<uint64_t>*>(base_ + header_->readOffset);
+		buffer_ = reinterpret_cast<DataType*>(base_ + header_->dataOffset);
+		size_ = static_cast<std::size_t>(header_->capacity);
+		isPowerOfTwo_ = (size_ & (size_ - 1)) == 0;
+		pReadIndex_ = readIndex_->load(std::memory_order_acquire);
+		pWriteIndex_ = writeIndex_->load(std::memory_order_acquire);
+	}
+
+	// given any index, return slot in [0,Size-1]
+	// branch on isPowerOfTwo_ never changes, so predicts perfectly
+	std::size_t Mod1N(uint64_t index) const
+	{
+		if (isPowerOfTwo_)
+			return static_cast<std::size_t>(index & (size_ - 1));
+		return static_cast<std::size_t>(index % size_);
+	}
+
+	// spans covering n items starting at buffer position t in [0,N-1], split at the end of the buffer
+	RingSpans<DataType> MakeSpans(std::size_t t, std::size_t n)
+	{
+		const auto firstSize = n < size_ - t ? n : size_ - t;
+		return { buffer_ + t, firstSize, buffer_, n - firstSize };
+	}
+
+	char * base_;        // this process' mapping of the segment
+	std::size_t bytes_;
+	std::string name_;   // set for the creator of a named segment, unlinked on destroy
+	SharedRingHeader * header_;
+
+	// pointers into the segment, computed from the header offsets
+	std::atomic<uint64_t> * writeIndex_{ nullptr };
+	std::atomic<uint64_t> * readIndex_{ nullptr };
+	DataType * buffer_{ nullptr };
+	std::size_t size_{ 0 };
+	bool isPowerOfTwo_{ false };
+
+	// local to this process, only the side that owns them uses them
+	uint64_t pReadIndex_{ 0 };  // producer: predictive read index
+	uint64_t pWriteIndex_{ 0 }; // consumer: predictive write index
+};
+
+} // namespace Lomont
+
+#endif // __linux__
+
+#endif // SHARED_RING_BUFFER_H
@@ -117,6 +117,12 @@ public:
         	e += ::ElapsedMs()-start_;
     	return e;
 	}
+
+	// return elapsed nanoseconds since start, at millisecond resolution
+	uint64_t ElapsedNs() const
+	{
+    	return ElapsedMs() * 1'000'000ULL;
+	}
 	
 	private:
 	uint32_t start_;
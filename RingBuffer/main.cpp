@@ -18,6 +18,18 @@
 #include "CacheRingBuffer.h"   // move read/write to other locations for cache help
 #include "BlocksRingBuffer.h"  // add read/write in blocks
 #include "RingBuffer.h"        // add predictive read/write locations to loosen false sharing
+#include "MappedRingBuffer.h"  // storage mapped twice so blocks never wrap, Linux only
+#include "DynamicRingBuffer.h" // runtime size, heap storage
+#include "MpscRingBuffer.h"    // multiple producers, one SPSC lane each
+#include "BroadcastRingBuffer.h" // one producer, every consumer sees every item
+#include "MpmcRingBuffer.h"    // many producers and consumers, each item to one consumer
+#include "SharedRingBuffer.h"  // shared memory, producer and consumer in different processes, Linux
+#include "MessageRingBuffer.h" // variable length messages, framed, never split at the wrap
+#include "OverwriteRingBuffer.h" // lossy, producer overwrites oldest, never waits
+#include "AsyncRingBuffer.h"   // C++20 coroutine awaitable put/get, single threaded executor
+#include "EventRingBuffer.h"   // eventfd signalled on empty to non-empty, for epoll loops, Linux
+#include "Affinity.h"          // CPU topology, pin benchmark threads
+#include "PerfCounters.h"      // hardware counters per pass, Linux
 
 // send output here
 void WriteLine(const char * line);
@@ -231,12 +243,17 @@ void PerformanceV(int bytes)
 	ThroughputSingle<128, 16, RingBuffer       <128>>(bytes);
 	ThroughputSingleBlock<128, 16, BlocksRingBuffer <128>>(bytes*3);
 	ThroughputSingleBlock<128, 16, RingBuffer       <128>>(bytes*3);
+	ThroughputSingleZeroCopy<128, 16, RingBuffer    <128>>(bytes*3);
 
 	bytes /= 6;
 	ThroughputDouble<128, 16, BlocksRingBuffer <128>>(bytes/3);
 	ThroughputDouble<128, 16, RingBuffer       <128>>(bytes/3);
 	ThroughputDoubleBlock<128, 16, BlocksRingBuffer <128>>(bytes*4);
 	ThroughputDoubleBlock<128, 16, RingBuffer       <128>>(bytes*4);
+	ThroughputDoubleZeroCopy<128, 16, RingBuffer    <128>>(bytes*4);
+	ThroughputDoubleSome<128, 16, RingBuffer        <128>>(bytes*4);
+	ThroughputDoubleConsume<128, 16, RingBuffer     <128>>(bytes*4);
+	ThroughputDoubleHandles<128, 16, RingBuffer     <128>>(bytes/3);
 }
 
 void PerformanceVI(int bytes)
@@ -280,6 +297,13 @@ bool TestSanity(long size)
 	success &= SanityCheck<31, 3, RingBuffer<31>>(size);
 	success &= SanityCheck<32, 3, RingBuffer<32>>(size);
 	success &= SanityCheck<33, 3, RingBuffer<33>>(size);
+	success &= OwnershipCheck<16>();
+	success &= OwnershipCheck<17>();
+	success &= OverwriteCheck<16, OverwriteRingBuffer<16, uint32_t>>();
+	success &= OverwriteCheck<17, OverwriteRingBuffer<17, uint32_t>>();
+	success &= PeekCheck<16>();
+	success &= PeekCheck<17>();
+	success &= PeekCheck<17, SequenceRingBuffer<17>>();
 	if (success)
 		WriteLine("Sanity passed");
 	else
@@ -292,7 +316,7 @@ void TestAllSingle()
 {
 	constexpr size_t N = 256;
 	constexpr size_t M = 16;
-	long size = 1'000'000; // pick sizes so that each sample around 25 ms
+	long size = 1'000'000; // starting sizes, Stats calibrates each pass toward 25 ms
 	ThroughputSingle<N, M, SimpleRingBuffer <N>>(size*3);   // single thread, simple to implement
 	ThroughputSingle<N, M, GenericRingBuffer<N>>(size*10);   // Templatized things									  
 	ThroughputSingle<N, M, LockedRingBuffer <N>>(size/5);   // added locks, API now bad
@@ -312,7 +336,7 @@ void TestAllDouble()
 {
 	constexpr size_t N = 256;
 	constexpr size_t M = 16;
-	long size = 500'000; // pick sizes so that each sample around 25 ms
+	long size = 500'000; // starting sizes, Stats calibrates each pass toward 25 ms
 	ThroughputDouble<N, M, LockedRingBuffer <N>>(size / 50);   // added locks, API now bad
 	ThroughputDouble<N, M, AtomicsRingBuffer<N>>(size);   // SPSC using atomics
 	ThroughputDouble<N, M, ModulusRingBuffer<N, char, uint32_t, SlowRingMod<N, uint32_t>>>(size); // replaced modulus, old method
@@ -323,12 +347,15 @@ void TestAllDouble()
 	ThroughputDouble<N, M, CacheRingBuffer  <N>>(size * 4);   // cache lines
 	ThroughputDouble<N, M, BlocksRingBuffer <N>>(size * 4);   // read/write blocks
 	ThroughputDouble<N, M, RingBuffer       <N>>(size * 4);   // added predictive read/write to avoid false sharing
+	ThroughputDoubleHandles<N, M, RingBuffer<N>>(size * 4);   // role handles, cached indices, cheaper polling
 }
 
 void TestTimingBySize()
 {
 	constexpr size_t N = 256;
 	constexpr size_t M = 140;
+	const auto targetMs = Stats::targetMs;
+	Stats::targetMs = 0; // the sizes are the experiment, keep them
 	ThroughputSingle<N, M, SimpleRingBuffer <N>>(100'000);   // single thread, simple to implement
 	ThroughputSingle<N, M, SimpleRingBuffer <N>>(200'000);   // single thread, simple to implement
 	ThroughputSingle<N, M, SimpleRingBuffer <N>>(400'000);   // single thread, simple to implement
@@ -339,9 +366,392 @@ void TestTimingBySize()
 	ThroughputSingle<N, M, SimpleRingBuffer <N>>(12'800'000);   // single thread, simple to implement
 	ThroughputSingle<N, M, SimpleRingBuffer <N>>(25'600'000);   // single thread, simple to implement
 	ThroughputSingle<N, M, SimpleRingBuffer <N>>(51'200'000);   // single thread, simple to implement
+	Stats::targetMs = targetMs;
+}
+
+// sweep block sizes through the two thread block path
+void TestBlockSizes()
+{
+	constexpr size_t N = 8192;
+	long size = 50'000'000;
+	ThroughputDoubleBlock<N,   16, BlocksRingBuffer<N>>(size);
+	ThroughputDoubleBlock<N,   16, RingBuffer      <N>>(size);
+	ThroughputDoubleBlock<N,   32, BlocksRingBuffer<N>>(size);
+	ThroughputDoubleBlock<N,   32, RingBuffer      <N>>(size);
+	ThroughputDoubleBlock<N,   64, BlocksRingBuffer<N>>(size);
+	ThroughputDoubleBlock<N,   64, RingBuffer      <N>>(size);
+	ThroughputDoubleBlock<N,  128, BlocksRingBuffer<N>>(size);
+	ThroughputDoubleBlock<N,  128, RingBuffer      <N>>(size);
+	ThroughputDoubleBlock<N,  256, BlocksRingBuffer<N>>(size);
+	ThroughputDoubleBlock<N,  256, RingBuffer      <N>>(size);
+	ThroughputDoubleBlock<N,  512, BlocksRingBuffer<N>>(size);
+	ThroughputDoubleBlock<N,  512, RingBuffer      <N>>(size);
+	ThroughputDoubleBlock<N, 1024, BlocksRingBuffer<N>>(size);
+	ThroughputDoubleBlock<N, 1024, RingBuffer      <N>>(size);
+	ThroughputDoubleBlock<N, 2048, BlocksRingBuffer<N>>(size);
+	ThroughputDoubleBlock<N, 2048, RingBuffer      <N>>(size);
+	ThroughputDoubleBlock<N, 4096, BlocksRingBuffer<N>>(size);
+	ThroughputDoubleBlock<N, 4096, RingBuffer      <N>>(size);
+	ThroughputDoubleSome <N, 4096, RingBuffer      <N>>(size);
+}
+
+// embedded array vs double mapped storage for large byte streams
+void PerformanceMapped(long size)
+{
+#ifdef __linux__
+	constexpr size_t M = 4096;
+	constexpr size_t K64 = 64 << 10, M1 = 1 << 20, M16 = 16 << 20, M64 = 64 << 20;
+	const auto targetMs = Stats::targetMs;
+	Stats::targetMs = 0; // passes must cycle the largest rings several times, keep the size
+
+	WriteLine("Performance mapped - single");
+	ThroughputSingleBlock<K64, M, RingBuffer      <K64>>(size);
+	ThroughputSingleBlock<K64, M, MappedRingBuffer<   >>(size);
+	ThroughputSingleBlock<M1,  M, RingBuffer      <M1 >>(size);
+	ThroughputSingleBlock<M1,  M, MappedRingBuffer<   >>(size);
+	ThroughputSingleBlock<M16, M, RingBuffer      <M16>>(size);
+	ThroughputSingleBlock<M16, M, MappedRingBuffer<   >>(size);
+	ThroughputSingleBlock<M64, M, RingBuffer      <M64>>(size);
+	ThroughputSingleBlock<M64, M, MappedRingBuffer<   >>(size);
+
+	WriteLine("Performance mapped - double");
+	ThroughputDoubleBlock<K64, M, RingBuffer      <K64>>(size);
+	ThroughputDoubleBlock<K64, M, MappedRingBuffer<   >>(size);
+	ThroughputDoubleBlock<M1,  M, RingBuffer      <M1 >>(size);
+	ThroughputDoubleBlock<M1,  M, MappedRingBuffer<   >>(size);
+	ThroughputDoubleBlock<M16, M, RingBuffer      <M16>>(size);
+	ThroughputDoubleBlock<M16, M, MappedRingBuffer<   >>(size);
+	ThroughputDoubleBlock<M64, M, RingBuffer      <M64>>(size);
+	ThroughputDoubleBlock<M64, M, MappedRingBuffer<   >>(size);
+	Stats::targetMs = targetMs;
+#else
+	(void)size;
+#endif
+}
+
+// compile time size vs runtime size at equal sizes
+void PerformanceDynamic(int bytes)
+{
+	WriteLine("Performance dynamic - single");
+	ThroughputSingle<127, 16, RingBuffer       <127>>(bytes);
+	ThroughputSingle<127, 16, DynamicRingBuffer<   >>(bytes);
+	ThroughputSingle<128, 16, RingBuffer       <128>>(bytes);
+	ThroughputSingle<128, 16, DynamicRingBuffer<   >>(bytes);
+	ThroughputSingleBlock<127,  16, RingBuffer       <127>>(bytes * 3);
+	ThroughputSingleBlock<127,  16, DynamicRingBuffer<   >>(bytes * 3);
+	ThroughputSingleBlock<128,  16, RingBuffer       <128>>(bytes * 3);
+	ThroughputSingleBlock<128,  16, DynamicRingBuffer<   >>(bytes * 3);
+	ThroughputSingleBlock<4096, 1024, RingBuffer       <4096>>(bytes * 30);
+	ThroughputSingleBlock<4096, 1024, DynamicRingBuffer<    >>(bytes * 30);
+
+	WriteLine("Performance dynamic - double");
+	bytes /= 5;
+	ThroughputDouble<127, 16, RingBuffer       <127>>(bytes);
+	ThroughputDouble<127, 16, DynamicRingBuffer<   >>(bytes);
+	ThroughputDouble<128, 16, RingBuffer       <128>>(bytes);
+	ThroughputDouble<128, 16, DynamicRingBuffer<   >>(bytes);
+	ThroughputDoubleBlock<127,  16, RingBuffer       <127>>(bytes * 20);
+	ThroughputDoubleBlock<127,  16, DynamicRingBuffer<   >>(bytes * 20);
+	ThroughputDoubleBlock<128,  16, RingBuffer       <128>>(bytes * 20);
+	ThroughputDoubleBlock<128,  16, DynamicRingBuffer<   >>(bytes * 20);
+	ThroughputDoubleBlock<4096, 1024, RingBuffer       <4096>>(bytes * 200);
+	ThroughputDoubleBlock<4096, 1024, DynamicRingBuffer<    >>(bytes * 200);
+}
+
+// RingBuffer with each field layout
+template<size_t N, typename Layout>
+using LayoutRingBuffer = RingBuffer<N, char, int32_t, FastRingMod<N, int32_t>, Layout>;
+
+// sweep field layouts, matters most for small N where fields share cache lines
+void PerformanceLayout(int bytes)
+{
+	WriteLine("Performance layout - double");
+	ThroughputDouble<29,  16, LayoutRingBuffer<29,  PackedLayout>>(bytes);
+	ThroughputDouble<29,  16, LayoutRingBuffer<29,  PaddedLayout>>(bytes);
+	ThroughputDouble<29,  16, LayoutRingBuffer<29,  SplitLayout >>(bytes);
+	ThroughputDouble<32,  16, LayoutRingBuffer<32,  PackedLayout>>(bytes);
+	ThroughputDouble<32,  16, LayoutRingBuffer<32,  PaddedLayout>>(bytes);
+	ThroughputDouble<32,  16, LayoutRingBuffer<32,  SplitLayout >>(bytes);
+	ThroughputDouble<50,  16, LayoutRingBuffer<50,  PackedLayout>>(bytes);
+	ThroughputDouble<50,  16, LayoutRingBuffer<50,  PaddedLayout>>(bytes);
+	ThroughputDouble<50,  16, LayoutRingBuffer<50,  SplitLayout >>(bytes);
+	ThroughputDouble<128, 16, LayoutRingBuffer<128, PackedLayout>>(bytes);
+	ThroughputDouble<128, 16, LayoutRingBuffer<128, PaddedLayout>>(bytes);
+	ThroughputDouble<128, 16, LayoutRingBuffer<128, SplitLayout >>(bytes);
+}
+
+// blocking put/get under each wait strategy
+void PerformanceWait(int bytes)
+{
+	WriteLine("Performance wait - double");
+	ThroughputDoubleWait<128, 16, RingBuffer<128>, SpinWait   >(bytes);
+	ThroughputDoubleWait<128, 16, RingBuffer<128>, BackoffWait>(bytes);
+	ThroughputDoubleWait<128, 16, RingBuffer<128>, YieldWait  >(bytes);
+#ifdef __cpp_lib_atomic_wait
+	ThroughputDoubleWait<128, 16, RingBuffer<128>, ParkWait   >(bytes);
+#endif
+}
+
+// publish indices every K items vs every item
+void PerformanceBatched(int bytes)
+{
+	WriteLine("Performance batched - double");
+	ThroughputDouble       <128, 16, RingBuffer<128>>(bytes);
+	ThroughputDoubleBatched<128,  1, RingBuffer<128>>(bytes);
+	ThroughputDoubleBatched<128,  2, RingBuffer<128>>(bytes);
+	ThroughputDoubleBatched<128,  4, RingBuffer<128>>(bytes);
+	ThroughputDoubleBatched<128,  8, RingBuffer<128>>(bytes);
+	ThroughputDoubleBatched<128, 16, RingBuffer<128>>(bytes);
+	ThroughputDoubleBatched<128, 32, RingBuffer<128>>(bytes);
+	ThroughputDoubleBatched<128, 64, RingBuffer<128>>(bytes);
 }
 
 #ifndef SAMD21_BUILD // ARM board
+// index policies, indices mod 2N against free running sequence numbers
+void PerformanceSequence(int bytes)
+{
+	WriteLine("Performance index policy - single");
+	ThroughputSingle<127, 16, RingBuffer<127, char, int32_t,  MidRingMod<127, int32_t>>>(bytes);
+	ThroughputSingle<127, 16, SequenceRingBuffer<127>>(bytes);
+	ThroughputSingle<128, 16, RingBuffer<128, char, int32_t,  MidRingMod<128, int32_t>>>(bytes);
+	ThroughputSingle<128, 16, RingBuffer<128, char, int32_t, FastRingMod<128, int32_t>>>(bytes);
+	ThroughputSingle<128, 16, SequenceRingBuffer<128>>(bytes);
+	WriteLine("Performance index policy - double");
+	ThroughputDouble<127, 16, RingBuffer<127, char, int32_t,  MidRingMod<127, int32_t>>>(bytes);
+	ThroughputDouble<127, 16, SequenceRingBuffer<127>>(bytes);
+	ThroughputDouble<128, 16, RingBuffer<128, char, int32_t,  MidRingMod<128, int32_t>>>(bytes);
+	ThroughputDouble<128, 16, RingBuffer<128, char, int32_t, FastRingMod<128, int32_t>>>(bytes);
+	ThroughputDouble<128, 16, SequenceRingBuffer<128>>(bytes);
+	WriteLine("Performance index policy - double block");
+	ThroughputDoubleBlock<127, 16, RingBuffer<127, char, int32_t,  MidRingMod<127, int32_t>>>(bytes);
+	ThroughputDoubleBlock<127, 16, SequenceRingBuffer<127>>(bytes);
+	ThroughputDoubleBlock<128, 16, RingBuffer<128, char, int32_t, FastRingMod<128, int32_t>>>(bytes);
+	ThroughputDoubleBlock<128, 16, SequenceRingBuffer<128>>(bytes);
+}
+
+template<size_t P, size_t N, typename Scan>
+using MpscRing = MpscRingBuffer<P, N, uint32_t, int32_t, Scan>;
+
+// many producers into one consumer, per producer lanes
+void PerformanceMpsc(int bytes)
+{
+	WriteLine("Performance mpsc - round robin scan");
+	ThroughputMpsc<1024, 64,  1, MpscRing< 1, 1024, RoundRobinScan>>(bytes);
+	ThroughputMpsc<1024, 64,  2, MpscRing< 2, 1024, RoundRobinScan>>(bytes);
+	ThroughputMpsc<1024, 64,  4, MpscRing< 4, 1024, RoundRobinScan>>(bytes);
+	ThroughputMpsc<1024, 64,  8, MpscRing< 8, 1024, RoundRobinScan>>(bytes);
+	ThroughputMpsc<1024, 64, 16, MpscRing<16, 1024, RoundRobinScan>>(bytes);
+	WriteLine("Performance mpsc - occupancy scan");
+	ThroughputMpsc<1024, 64,  1, MpscRing< 1, 1024, OccupancyScan >>(bytes);
+	ThroughputMpsc<1024, 64,  2, MpscRing< 2, 1024, OccupancyScan >>(bytes);
+	ThroughputMpsc<1024, 64,  4, MpscRing< 4, 1024, OccupancyScan >>(bytes);
+	ThroughputMpsc<1024, 64,  8, MpscRing< 8, 1024, OccupancyScan >>(bytes);
+	ThroughputMpsc<1024, 64, 16, MpscRing<16, 1024, OccupancyScan >>(bytes);
+}
+
+// one producer fanned out to several consumers through one buffer
+void PerformanceBroadcast(int bytes)
+{
+	WriteLine("Performance broadcast - double block");
+	ThroughputBroadcast<1024, 64, 1, BroadcastRingBuffer<1, 1024>>(bytes);
+	ThroughputBroadcast<1024, 64, 2, BroadcastRingBuffer<2, 1024>>(bytes);
+	ThroughputBroadcast<1024, 64, 4, BroadcastRingBuffer<4, 1024>>(bytes);
+	ThroughputBroadcast<1024, 64, 8, BroadcastRingBuffer<8, 1024>>(bytes);
+	WriteLine("Performance broadcast - compare one SPSC ring");
+	ThroughputDoubleBlock<1024, 64, RingBuffer<1024>>(bytes);
+}
+
+// contention scaling of the MPMC queue, compare the SPSC ring
+void PerformanceMpmc(int bytes)
+{
+	WriteLine("Performance mpmc - single items");
+	ThroughputMpmc<1024,  1, 1, 1, MpmcRingBuffer<1024, uint32_t>>(bytes);
+	ThroughputMpmc<1024,  1, 2, 2, MpmcRingBuffer<1024, uint32_t>>(bytes);
+	ThroughputMpmc<1024,  1, 4, 4, MpmcRingBuffer<1024, uint32_t>>(bytes);
+	ThroughputMpmc<1024,  1, 1, 4, MpmcRingBuffer<1024, uint32_t>>(bytes);
+	ThroughputMpmc<1024,  1, 4, 1, MpmcRingBuffer<1024, uint32_t>>(bytes);
+	WriteLine("Performance mpmc - blocks");
+	ThroughputMpmc<1024, 16, 1, 1, MpmcRingBuffer<1024, uint32_t>>(bytes);
+	ThroughputMpmc<1024, 16, 2, 2, MpmcRingBuffer<1024, uint32_t>>(bytes);
+	ThroughputMpmc<1024, 16, 4, 4, MpmcRingBuffer<1024, uint32_t>>(bytes);
+	WriteLine("Performance mpmc - compare SPSC");
+	ThroughputDouble     <1024, 16, RingBuffer<1024>>(bytes);
+	ThroughputDoubleBlock<1024, 16, RingBuffer<1024>>(bytes);
+}
+
+// producer and consumer in separate processes, compare in process threads
+void PerformanceProcess(int bytes)
+{
+#ifdef __linux__
+	WriteLine("Performance shared memory - double");
+	ThroughputDoubleProcess<128,  16, SharedRingBuffer<char>>(bytes);
+	ThroughputDouble       <128,  16, RingBuffer<128>      >(bytes);
+	ThroughputDoubleProcess<1024, 16, SharedRingBuffer<char>>(bytes);
+	ThroughputDouble       <1024, 16, RingBuffer<1024>     >(bytes);
+#else
+	(void)bytes;
+	WriteLine("Performance shared memory - needs Linux");
+#endif
+}
+
+// heavy items through the ring, copy vs move
+void PerformanceObjects(int bytes)
+{
+	WriteLine("Performance strings - double");
+	ThroughputDoubleStrings<128, 1, false>(bytes);
+	ThroughputDoubleStrings<128, 1, true >(bytes);
+}
+
+// variable length messages across size distributions
+void PerformanceMessages(int bytes)
+{
+	WriteLine("Performance messages - double");
+	ThroughputMessages<4096, MessageRingBuffer<4096>>(bytes, 32);
+	ThroughputMessages<4096, MessageRingBuffer<4096>>(bytes, 256);
+	ThroughputMessages<4096, MessageRingBuffer<4096>>(bytes, 2048);
+	ThroughputMessages<4000, MessageRingBuffer<4000>>(bytes, 256);
+}
+
+// lossy ring, producer never waits, reports how much the consumer missed
+void PerformanceOverwrite(int bytes)
+{
+	WriteLine("Performance overwrite - double");
+	ThroughputOverwrite<128,  16, OverwriteRingBuffer<128,  uint32_t>>(bytes);
+	ThroughputOverwrite<1024, 16, OverwriteRingBuffer<1024, uint32_t>>(bytes);
+	ThroughputOverwrite<4096, 16, OverwriteRingBuffer<4096, uint32_t>>(bytes);
+}
+
+// coroutine awaitables vs the plain single thread loop, one item at a time
+void PerformanceAsync(int bytes)
+{
+#ifdef RING_HAS_COROUTINES
+	WriteLine("Performance coroutines - single thread");
+	const auto targetMs = Stats::targetMs;
+	Stats::targetMs = 0; // the item count is the experiment, keep it
+	ThroughputSingle<128,  1, RingBuffer<128>          >(bytes);
+	ThroughputAsync <128,  1, AsyncRingBuffer<128>     >(bytes);
+	ThroughputSingle<1024, 1, RingBuffer<1024>         >(bytes);
+	ThroughputAsync <1024, 1, AsyncRingBuffer<1024>    >(bytes);
+	Stats::targetMs = targetMs;
+#else
+	(void)bytes;
+	WriteLine("Performance coroutines - needs C++20");
+#endif
+}
+
+// consumer in epoll on an eventfd, bursty traffic gives wakeups, streaming should give none
+void PerformanceEvent(int bytes)
+{
+#ifdef __linux__
+	WriteLine("Performance eventfd - double");
+	const auto targetMs = Stats::targetMs;
+	Stats::targetMs = 0; // burst counts and pauses are the experiment, keep them
+	ThroughputEvent<1024, 1,    EventRingBuffer<1024, uint64_t>>(bytes / 100, 100); // every item wakes
+	ThroughputEvent<1024, 64,   EventRingBuffer<1024, uint64_t>>(bytes / 10, 100);  // bursts
+	ThroughputEvent<1024, 1024, EventRingBuffer<1024, uint64_t>>(bytes, 0);         // streaming
+	Stats::targetMs = targetMs;
+#else
+	(void)bytes;
+	WriteLine("Performance eventfd - needs Linux");
+#endif
+}
+
+// round trip latency through two rings, each SPSC variant
+void PerformanceLatency(long roundTrips)
+{
+	constexpr size_t N = 128;
+	WriteLine("Performance ping pong latency");
+	ShowLatencyFormat();
+	LatencyPingPong<N, AtomicsRingBuffer<N, uint64_t>>(roundTrips);   // SPSC using atomics
+	LatencyPingPong<N, ModulusRingBuffer<N, uint64_t>>(roundTrips);   // power of 2 specialized
+	LatencyPingPong<N, RelaxedRingBuffer<N, uint64_t>>(roundTrips);   // relaxed atomic memory model
+	LatencyPingPong<N, FullRingBuffer   <N, uint64_t>>(roundTrips);   // use all items
+	LatencyPingPong<N, CacheRingBuffer  <N, uint64_t>>(roundTrips);   // cache lines
+	LatencyPingPong<N, BlocksRingBuffer <N, uint64_t>>(roundTrips);   // read/write blocks
+	LatencyPingPong<N, RingBuffer       <N, uint64_t>>(roundTrips);   // predictive read/write
+	LatencyPingPong<N, RingBuffer<N, uint64_t, int32_t, FastRingMod<N, int32_t>, PaddedLayout>>(roundTrips, true); // fields on own lines, with histogram
+}
+
+// two thread variants with producer and consumer pinned to each pair of CPUs,
+// by default one pair per placement found in the topology, nearest first,
+// given pairs are classified by CPU id, and dropped if the process may not use them
+void PerformancePlacement(int bytes, std::vector<CpuPair> pairs = {})
+{
+	constexpr size_t N = 128;
+	constexpr size_t M = 16;
+	CpuTopology topology;
+	if (pairs.empty())
+		pairs = topology.PairsByPlacement();
+	else
+	{
+		std::vector<CpuPair> usable;
+		for (const auto & given : pairs)
+		{
+			CpuPair pair;
+			if (topology.MakePair(given.producer, given.consumer, pair))
+				usable.push_back(pair);
+			else
+			{
+				char line[100];
+				sprintf(line, "Error: cannot use CPUs %d and %d, skipped", given.producer, given.consumer);
+				Error(line);
+			}
+		}
+		pairs = usable;
+	}
+	if (pairs.empty())
+		WriteLine("Performance placement - no usable CPU pairs, running unpinned");
+	pairs.insert(pairs.begin(), CpuPair{}); // unpinned baseline
+
+	for (const auto & pair : pairs)
+	{
+		char line[100];
+		sprintf(line, "Performance placement - %s, CPUs %d and %d", PlacementName(pair.placement), pair.producer, pair.consumer);
+		WriteLine(line);
+		testPair = pair;
+		ThroughputDouble<N, M, AtomicsRingBuffer<N>>(bytes);        // SPSC using atomics
+		ThroughputDouble<N, M, ModulusRingBuffer<N>>(bytes);        // power of 2 specialized
+		ThroughputDouble<N, M, RelaxedRingBuffer<N>>(bytes);        // relaxed atomic memory model
+		ThroughputDouble<N, M, FullRingBuffer   <N>>(bytes);        // use all items
+		ThroughputDouble<N, M, CacheRingBuffer  <N>>(bytes);        // cache lines
+		ThroughputDouble<N, M, RingBuffer       <N>>(bytes);        // predictive read/write
+		ThroughputDoubleBlock<N, M, BlocksRingBuffer<N>>(bytes);    // read/write blocks
+		ThroughputDoubleBlock<N, M, RingBuffer      <N>>(bytes);
+		ThroughputDoubleBlock<N, M, LayoutRingBuffer<N, PackedLayout>>(bytes); // field layouts
+		ThroughputDoubleBlock<N, M, LayoutRingBuffer<N, PaddedLayout>>(bytes);
+		ThroughputDoubleBlock<N, M, LayoutRingBuffer<N, SplitLayout >>(bytes);
+	}
+	testPair = CpuPair{};
+}
+
+// hardware counters next to throughput, to see the false sharing the layouts remove
+// counters read by both threads of the two thread tests, columns empty when not available
+void PerformanceCounters(int bytes)
+{
+	constexpr size_t N = 128;
+	constexpr size_t M = 16;
+	{
+		PerfCounters counters; // what this machine allows
+		char line[200];
+		sprintf(line, "Performance counters -");
+		for (auto i = 0; i < CounterCount; ++i)
+			sprintf(line + strlen(line), " %s %s,", CounterName((Counter)i), counters.Has((Counter)i) ? "yes" : "no");
+		WriteLine(line);
+		if (!counters.Available())
+			WriteLine("Performance counters - perf events not available, check /proc/sys/kernel/perf_event_paranoid");
+	}
+	Stats::perfCounters = true;
+	ThroughputDouble<N, M, AtomicsRingBuffer<N>>(bytes);        // SPSC using atomics
+	ThroughputDouble<N, M, RelaxedRingBuffer<N>>(bytes);        // relaxed atomic memory model
+	ThroughputDouble<N, M, FullRingBuffer   <N>>(bytes);        // use all items
+	ThroughputDouble<N, M, CacheRingBuffer  <N>>(bytes);        // cache lines
+	ThroughputDouble<N, M, RingBuffer       <N>>(bytes);        // predictive read/write
+	ThroughputDoubleBlock<N, M, LayoutRingBuffer<N, PackedLayout>>(bytes); // field layouts
+	ThroughputDoubleBlock<N, M, LayoutRingBuffer<N, PaddedLayout>>(bytes);
+	ThroughputDoubleBlock<N, M, LayoutRingBuffer<N, SplitLayout >>(bytes);
+	Stats::perfCounters = false;
+}
+
 int main()
 {
 
@@ -361,6 +771,25 @@ int main()
 	// determined that avg ms should be 25-50 to get good samples
 	// also fix sizes we test, say 256,16 in general
 	// TestTimingBySize(); 
+	// TestBlockSizes(); // block transfer size sweep
+	// PerformanceMapped(200'000'000); // double mapped storage, large rings, fixed 200MB passes
+	// PerformanceDynamic(3'000'000);  // runtime sized storage
+	// PerformanceLayout(2'000'000);   // field layouts vs false sharing
+	// PerformanceWait(2'000'000);     // blocking put/get wait strategies
+	// PerformanceBatched(2'000'000);  // batched index publication
+	// PerformanceSequence(2'000'000); // mod 2N indices vs 64 bit sequence numbers
+	// PerformanceMpsc(8'000'000);     // per producer lanes, 1 to 16 producers
+	// PerformanceBroadcast(8'000'000); // one producer, 1 to 8 consumers sharing a buffer
+	// PerformanceMpmc(8'000'000);     // work distributing queue, contention scaling
+	// PerformanceProcess(2'000'000);  // shared memory ring between two processes
+	// PerformanceObjects(20'000'000); // std::string items, copied or moved
+	// PerformanceMessages(50'000'000); // framed variable length messages
+	// PerformanceOverwrite(40'000'000); // lossy overwrite oldest mode
+	// PerformanceAsync(100'000'000);  // 100M items between two coroutines
+	// PerformanceEvent(80'000'000);   // epoll consumer, wakeup latency and syscall counts, fixed counts
+	// PerformanceLatency(1'000'000);  // ping pong round trip latency histograms
+	// PerformancePlacement(2'000'000); // pinned producer and consumer, per CPU placement
+	// PerformanceCounters(2'000'000); // cycles, IPC, cache misses per byte
 
 	//TestAllSingle();  // each through single threaded
 	//TestAllDouble();  // each through single threaded